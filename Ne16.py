@@ -29,6 +29,51 @@ class Ne16:
     def weights_size(self, ko, ki, ks, qw, dw):
         return self.weights_ko_len(ko, dw) * self.weights_ki_size(ki, ks, qw, dw)
 
+    def weights_plane_size(self, ks):
+        return ks[0] * ks[1] * (self.TP_IN // 8)
+
+    def weights_planes_per_group(self, ki, qw, dw):
+        """ Bit planes of an output channel, or of 16 channels if depthwise """
+        return qw if dw else div_and_ceil(ki, self.TP_IN) * qw
+
+    def groups_per_job(self, ki_group, groups):
+        """ Groups convolved by one job of a grouped convolution
+
+        Small groups are batched, with block diagonal weights, until they fill
+        the input channels the NE16 processes at once.
+        """
+        n = max(1, self.TP_IN // ki_group)
+        while groups % n != 0:
+            n -= 1
+        return n
+
+    # Zero bit-plane coding of the packed weights. Every (Ko, KiMajor, Qw) bit
+    # plane is contiguous in the packed layout and is either all zeros, in which
+    # case it is only flagged in the bitmap, or stored as a literal.
+    # Offsets point to the first literal of every group of planes so that the
+    # groups can be decompressed independently.
+    def compress_weights(self, wbytes, ko, ki, ks, qw, dw=False):
+        plane_size = self.weights_plane_size(ks)
+        planes = wbytes.reshape(-1, plane_size)
+        nonzero = planes.any(axis=1)
+
+        bitmap = np.packbits(nonzero, bitorder='little')
+        literals = planes[nonzero].reshape(-1)
+
+        counts = nonzero.reshape(self.weights_ko_len(ko, dw), self.weights_planes_per_group(ki, qw, dw)).sum(axis=1)
+        offsets = np.concatenate(([0], np.cumsum(counts))) * plane_size
+
+        return bitmap, offsets.astype(np.uint32), literals
+
+    def decompress_weights(self, bitmap, literals, ko, ki, ks, qw, dw=False):
+        plane_size = self.weights_plane_size(ks)
+        n_planes = self.weights_ko_len(ko, dw) * self.weights_planes_per_group(ki, qw, dw)
+        nonzero = np.unpackbits(bitmap, bitorder='little')[:n_planes].astype(bool)
+
+        planes = np.zeros((n_planes, plane_size), dtype=np.uint8)
+        planes[nonzero] = literals.reshape(-1, plane_size)
+        return planes.reshape(-1)
+
     # assuming torch shapes, w must already be in uint format!
     # format --> [Ko, KiMajor, Qw, KiMinor] (binary tensor)
     #                          +++++++++++ --> these are *contiguous and packed*
@@ -0,0 +1,155 @@
+# arena.py
+# Luka Macan <luka.macan@fer.hr>
+#
+# Copyright (C) 2022 University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# The NE16 streamers access the TCDM with word-aligned accesses
+NE16_STREAM_ALIGNMENT = 4
+
+
+def align_up(x, alignment):
+    return (x + alignment - 1) // alignment * alignment
+
+
+class Buffer:
+    """ L1 buffer live during a set of steps of a schedule
+
+    Steps are abstract points of a schedule, e.g. the layers of a network or
+    the stages of a pipeline. Two buffers can share memory only if they are
+    never live in the same step.
+    """
+
+    def __init__(self, name, size, live, alignment=NE16_STREAM_ALIGNMENT):
+        self.name = name
+        self.size = size
+        self.live = frozenset(live)
+        self.alignment = alignment
+
+    def interferes(self, other):
+        return not self.live.isdisjoint(other.live)
+
+
+def unplanned_size(buffers):
+    """ L1 taken by the buffers as separate globals """
+    return sum(align_up(b.size, b.alignment) for b in buffers)
+
+
+def _place(buffers):
+    offsets = {}
+    placed = []
+    for buffer in buffers:
+        # Ranges taken by the buffers live at the same time, in address order
+        taken = sorted((offsets[p.name], offsets[p.name] + p.size) for p in placed if p.interferes(buffer))
+        offset = 0
+        for start, end in taken:
+            if align_up(offset, buffer.alignment) + buffer.size <= start:
+                break
+            offset = max(offset, end)
+        offsets[buffer.name] = align_up(offset, buffer.alignment)
+        placed.append(buffer)
+    size = max((offsets[b.name] + b.size for b in buffers), default=0)
+    return offsets, size
+
+
+def plan(buffers, alignment=NE16_STREAM_ALIGNMENT):
+    """ Packs the buffers into one arena, reusing the memory of dead buffers
+
+    Buffers are placed one by one at the lowest offset that does not overlap
+    a buffer live at the same time. The placement order matters, so a few
+    orders are tried and the smallest arena is kept.
+
+    Returns the offsets by buffer name and the size of the arena.
+    """
+    orders = [
+        sorted(buffers, key=lambda b: (-b.size, b.name)),
+        sorted(buffers, key=lambda b: (-len(b.live), -b.size, b.name)),
+        sorted(buffers, key=lambda b: (-len(b.live) * b.size, b.name))
+    ]
+    offsets, size = min((_place(order) for order in orders), key=lambda result: result[1])
+    check(buffers, offsets)
+    return offsets, align_up(size, alignment)
+
+
+def check(buffers, offsets):
+    """ Asserts that buffers live at the same time never overlap and are aligned """
+    for buffer in buffers:
+        assert offsets[buffer.name] % buffer.alignment == 0, f'{buffer.name} is misaligned'
+    for i, a in enumerate(buffers):
+        for b in buffers[i + 1:]:
+            if not a.interferes(b):
+                continue
+            a_start, b_start = offsets[a.name], offsets[b.name]
+            assert a_start + a.size <= b_start or b_start + b.size <= a_start, \
+                f'{a.name} and {b.name} are live at the same time but overlap'
+
+
+def tiled_layer_buffers(sizes):
+    """ Buffers of nnx_run_tiled with their lifetimes over one period of its pipeline
+
+    A period covers two tiles, one per NE16 context. While one context
+    computes, the core first finishes the other context's previous tile
+    (epilogue and store) and then loads its next operands:
+
+        step 0: context 0 computes, context 1 finishes
+        step 1: context 0 computes, context 1 loads
+        step 2: context 1 computes, context 0 finishes
+        step 3: context 1 computes, context 0 loads
+
+    Input, weights and scale keep their content between tiles to skip
+    reloads, so they are always live. The output is live from the start of
+    the job until it is stored. Compressed weights are only staged while they
+    are expanded during the load, so they can share memory with the output of
+    their context.
+
+    The two outputs overlap in steps 0 and 2, so every buffer of a layer
+    without compressed weights interferes with every other one and the plan
+    saves nothing over separate buffers.
+    """
+    computes = [{0, 1}, {2, 3}]
+    finishes = [{2}, {0}]
+    loads = [{3}, {1}]
+    always = {0, 1, 2, 3}
+
+    buffers = []
+    for i in range(2):
+        for name, size in sizes.items():
+            if name == 'output':
+                live = computes[i] | finishes[i]
+            elif name == 'compressed':
+                live = loads[i]
+            else:
+                live = always
+            buffers.append(Buffer(f'{name}_{i}', size, live))
+    return buffers
+
+
+def plan_tiled_layer(sizes):
+    """ Arena of the tile buffers, in the form stored in the tile plan """
+    buffers = tiled_layer_buffers(sizes)
+    offsets, size = plan(buffers)
+    return {
+        'size': size,
+        'unplanned': unplanned_size(buffers),
+        'offsets': offsets,
+        'sizes': {b.name: b.size for b in buffers}
+    }
+
+
+def report(name, arena):
+    saved = arena['unplanned'] - arena['size']
+    print(f'{name} L1 peak: {arena["unplanned"]} bytes as separate buffers, {arena["size"]} bytes planned '
+          f'(saved {saved} bytes, {100 * saved / arena["unplanned"]:.1f}%)')
+    if saved <= 0:
+        print(f'{name}: no buffers share memory, all of them are live at the same time')
@@ -0,0 +1,282 @@
+# autotune.py
+# Luka Macan <luka.macan@fer.hr>
+#
+# Copyright (C) 2022 University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import os
+import math
+import json
+import hashlib
+import argparse
+from Ne16 import Ne16, div_and_ceil
+from arena import plan_tiled_layer
+
+CACHE_DIR = os.path.join('.cache', 'autotune')
+
+# Must match nnx_tile_order_e in pulp_nnx_rt.h
+TILE_ORDER_SPATIAL_OUTER = 0
+TILE_ORDER_CHANNEL_OUTER = 1
+
+
+class Ne16CostModel:
+    """ First order cycle model of a tiled NE16 layer
+
+    Compute is counted per 3x3 output subtile, 16-channel Ki block and 32-channel
+    Ko block (16-channel block for depthwise). Data movement counts the cluster
+    DMA traffic between L2 and L1, which is overlapped with compute thanks to the
+    double buffering.
+    """
+    VERSION = 2
+    DMA_BYTES_PER_CYCLE = 8
+    STREAMER_BYTES_PER_CYCLE = 32
+    JOB_OVERHEAD = 150  # acquire, offload, trigger and DMA programming
+    DMA_OVERHEAD = 30   # per DMA command
+
+    def __init__(self, ne16=Ne16()):
+        self.ne16 = ne16
+
+    def job_cycles(self, h, w, ko, ki, ks, qw, dw):
+        ne16 = self.ne16
+        n_subtiles = div_and_ceil(h, ne16.KS) * div_and_ceil(w, ne16.KS)
+        if dw:
+            n_ko = div_and_ceil(ko, ne16.TP_IN)
+            n_ki = 1
+        else:
+            n_ko = div_and_ceil(ko, ne16.TP_OUT)
+            n_ki = div_and_ceil(ki, ne16.TP_IN)
+        load = div_and_ceil(ne16.INPUT_BUFFER_H * ne16.INPUT_BUFFER_W * ne16.TP_IN, self.STREAMER_BYTES_PER_CYCLE)
+        mac = qw * (ks * ks if ks == 3 else 2)
+        store = ne16.KS * ne16.KS
+        return n_subtiles * n_ko * (n_ki * (load + mac) + store)
+
+    def tile_sizes(self, layer, tile):
+        h, w, ko = tile
+        ks, ki, qw, dw = layer['ks'], layer['cin'], layer['qw'], layer['dw']
+        ki = ko if dw else ki
+        sizes = {
+            'input': (h + ks - 1) * (w + ks - 1) * ki,
+            'weights': self.ne16.weights_size(ko, ki, (ks, ks), qw, dw),
+            'scale': ko * 4,
+            'output': h * w * ko
+        }
+        # Compressed weights are staged next to the expanded ones. The staging
+        # buffer is sized for the worst case of an incompressible tile.
+        if layer.get('compressed', False):
+            sizes['compressed'] = sizes['weights']
+        return sizes
+
+    def arena(self, layer, tile):
+        # Two buffers of each kind for the ping-pong between NE16 contexts,
+        # sharing memory where their lifetimes allow it
+        return plan_tiled_layer(self.tile_sizes(layer, tile))
+
+    def footprint(self, layer, tile):
+        return self.arena(layer, tile)['size']
+
+    def cycles(self, layer, tile, order, part=0, n_parts=1):
+        """ Cycles and DMA traffic of one NE16 running its part of the tiles
+
+        The tiles are shared between n_parts NE16 instances in contiguous
+        ranges, same as nnx_run_tiled_part does. The default is the whole layer.
+        """
+        H, W, K = layer['h'], layer['w'], layer['cout']
+        h, w, ko = tile
+        n_h, n_w, n_k = div_and_ceil(H, h), div_and_ceil(W, w), div_and_ceil(K, ko)
+        n_spatial = n_h * n_w
+        first, last = self.part_range(n_spatial * n_k, part, n_parts)
+        n_tiles = last - first
+        sizes = self.tile_sizes(layer, tile)
+
+        if n_tiles == 0:
+            return 0, 0
+
+        compute = 0
+        for i in range(first, last):
+            spatial, channel = self.tile_index(i, n_spatial, n_k, order)
+            th = min(h, H - spatial // n_w * h)
+            tw = min(w, W - spatial % n_w * w)
+            tk = min(ko, K - channel * ko)
+            compute += self.job_cycles(th, tw, tk, layer['cin'], layer['ks'], layer['qw'], layer['dw'])
+
+        input_loads, weight_loads = self.loads(n_spatial, n_k, order, layer['dw'], first, last)
+        traffic = input_loads * sizes['input'] \
+                  + weight_loads * (sizes['weights'] + sizes['scale']) \
+                  + n_tiles * sizes['output']
+        dma = traffic // self.DMA_BYTES_PER_CYCLE + (input_loads + 2 * weight_loads + n_tiles) * self.DMA_OVERHEAD
+
+        prologue = (sizes['input'] + sizes['weights'] + sizes['scale']) // self.DMA_BYTES_PER_CYCLE
+        epilogue = sizes['output'] // self.DMA_BYTES_PER_CYCLE
+        return max(compute, dma) + n_tiles * self.JOB_OVERHEAD + prologue + epilogue, traffic
+
+    @staticmethod
+    def part_range(n_tiles, part, n_parts):
+        return part * n_tiles // n_parts, (part + 1) * n_tiles // n_parts
+
+    @staticmethod
+    def tile_index(i, n_spatial, n_k, order):
+        if order == TILE_ORDER_SPATIAL_OUTER:
+            return i // n_k, i % n_k
+        else:
+            return i % n_spatial, i // n_spatial
+
+    @classmethod
+    def loads(cls, n_spatial, n_k, order, dw, first=0, last=None):
+        """ Counts the DMA loads of the runtime's double buffering
+
+        Every buffer keeps the operands it holds and only the ones that change
+        are reloaded, same as nnx_run_tiled does.
+        """
+        last = n_spatial * n_k if last is None else last
+        loaded = [None, None]
+        input_loads, weight_loads = 0, 0
+        for i in range(first, last):
+            spatial, channel = cls.tile_index(i, n_spatial, n_k, order)
+            b = (i - first) % 2
+            held = loaded[b]
+            if held is None or held[0] != spatial or (dw and held[1] != channel):
+                input_loads += 1
+            if held is None or held[1] != channel:
+                weight_loads += 1
+            loaded[b] = (spatial, channel)
+        return input_loads, weight_loads
+
+    @staticmethod
+    def _splits(dim, tile):
+        return [min(tile, dim - i) for i in range(0, dim, tile)]
+
+
+def candidates(dim, step):
+    """ Tile sizes aligned to step, the last one being the full dimension """
+    return sorted({min(step * i, dim) for i in range(1, div_and_ceil(dim, step) + 1)})
+
+
+def cache_key(layer, l1_budget):
+    record = dict(layer, l1_budget=l1_budget, model=Ne16CostModel.VERSION)
+    return hashlib.sha1(json.dumps(record, sort_keys=True).encode()).hexdigest()
+
+
+def search(layer, l1_budget, model=Ne16CostModel()):
+    ne16 = model.ne16
+    ko_step = ne16.TP_IN if layer['dw'] else ne16.TP_OUT
+    # Epilogues like pooling need tiles that are a multiple of their window
+    spatial_step = math.lcm(ne16.KS, layer.get('align', 1))
+    best = None
+    for h in candidates(layer['h'], spatial_step):
+        for w in candidates(layer['w'], spatial_step):
+            for ko in candidates(layer['cout'], ko_step):
+                tile = (h, w, ko)
+                footprint = model.footprint(layer, tile)
+                if footprint > l1_budget:
+                    continue
+                for order in [TILE_ORDER_SPATIAL_OUTER, TILE_ORDER_CHANNEL_OUTER]:
+                    cycles, traffic = model.cycles(layer, tile, order)
+                    score = (cycles, footprint)
+                    if best is None or score < best[0]:
+                        best = (score, {
+                            'height': h,
+                            'width': w,
+                            'depth': ko,
+                            'order': order,
+                            'cycles': cycles,
+                            'traffic': traffic,
+                            'footprint': footprint,
+                            'buffers': model.tile_sizes(layer, tile),
+                            'arena': model.arena(layer, tile)
+                        })
+
+    if best is None:
+        raise ValueError(f'No tiling of the layer fits into {l1_budget} bytes of L1.')
+
+    return best[1]
+
+
+def scaling(layer, plan, max_devices, model=Ne16CostModel()):
+    """ Modelled latency of the plan spread over 1 to max_devices NE16s
+
+    Every device is an independent instance of the cost model running its
+    part of the tiles, so the layer takes as long as the slowest part. Each
+    instance is assumed to have its own DMA, as NE16s of separate clusters do.
+    """
+    tile = (plan['height'], plan['width'], plan['depth'])
+    n_tiles = div_and_ceil(layer['h'], tile[0]) * div_and_ceil(layer['w'], tile[1]) * div_and_ceil(layer['cout'], tile[2])
+    rows = []
+    for n in range(1, max_devices + 1):
+        # Same split as nnx_run_tiled_part, every tile must run exactly once
+        covered = [0] * n_tiles
+        for part in range(n):
+            first, last = model.part_range(n_tiles, part, n)
+            for i in range(first, last):
+                covered[i] += 1
+        assert all(count == 1 for count in covered), f'The parts of {n} devices do not cover every tile exactly once'
+
+        parts = [model.cycles(layer, tile, plan['order'], part, n)[0] for part in range(n)]
+        rows.append({'devices': n, 'cycles': max(parts), 'sequential': sum(parts)})
+    return rows
+
+
+def autotune(layer, l1_budget, cache_dir=CACHE_DIR):
+    """ Returns the tile plan of the layer, either from the cache or by searching
+
+    The layer is described by a dictionary with the keys:
+    h, w (output spatial dimensions), cin, cout, ks, qw, dw and optionally
+    align, the spatial alignment required by the epilogue, and compressed, set
+    if the weights are stored compressed.
+    Input channels are never split since the NE16 cannot accumulate partial
+    sums across jobs, so only the output spatial dimensions and Ko are tiled.
+    """
+    key = cache_key(layer, l1_budget)
+    path = os.path.join(cache_dir, f'{key}.json')
+
+    if os.path.exists(path):
+        with open(path) as file:
+            print(f'Autotune cache hit -> {path}')
+            return json.load(file)
+
+    plan = search(layer, l1_budget)
+
+    os.makedirs(cache_dir, exist_ok=True)
+    with open(path, 'w') as file:
+        json.dump(plan, file, indent=2)
+
+    return plan
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--kernel-shape', '-ks', dest='kernel_shape', type=int, choices=[1, 3], default=3)
+    parser.add_argument('--channels-in', '-cin', dest='cin', type=int, default=16)
+    parser.add_argument('--channels-out', '-cout', dest='cout', type=int, default=32)
+    parser.add_argument('--output-spatial-dimensions', '-osd', dest='spatial_dimensions', type=int, default=3)
+    parser.add_argument('--depthwise', '-dw', dest='dw', action='store_true')
+    parser.add_argument('--compress-weights', dest='compress_weights', action='store_true')
+    parser.add_argument('--devices', dest='devices', type=int, default=1,
+                        help='Also model the layer spread over up to this many NE16s.')
+    parser.add_argument('--l1-budget', dest='l1_budget', type=int, required=True,
+                        help='Available L1 memory in bytes.')
+    args = parser.parse_args()
+
+    layer = {'h': args.spatial_dimensions, 'w': args.spatial_dimensions, 'cin': args.cin, 'cout': args.cout,
+             'ks': args.kernel_shape, 'qw': 8, 'dw': args.dw}
+    if args.compress_weights:
+        layer['compressed'] = True
+
+    plan = autotune(layer, args.l1_budget)
+    print(json.dumps(plan, indent=2))
+
+    if args.devices > 1:
+        rows = scaling(layer, plan, args.devices)
+        print(f'{"devices":>8} {"cycles":>10} {"speedup":>8} {"split cost":>11}')
+        for row in rows:
+            print(f'{row["devices"]:>8} {row["cycles"]:>10} {rows[0]["cycles"] / row["cycles"]:>8.2f} '
+                  f'{row["sequential"] - rows[0]["cycles"]:>11}')
@@ -0,0 +1,6 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+void bench(void *args);
+
+#endif  // __BENCH_H__
@@ -0,0 +1,121 @@
+#include <pmsis.h>
+
+#include "pulp_nnx.h"
+#include "bench.h"
+#include "bench_util.h"
+
+#define BENCH_REPS (16)
+#define BENCH_KERNEL_SIZE (4096)
+#define BENCH_KERNEL_PASSES (4)
+
+// 1x1 64->64 15x15 job
+#define BENCH_H (15)
+#define BENCH_W (15)
+#define BENCH_K (64)
+
+PI_L1 static uint8_t bench_input[BENCH_H * BENCH_W * BENCH_K] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_output[BENCH_H * BENCH_W * BENCH_K] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_weights[BENCH_K * (BENCH_K / 16) * 8 * 2] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_scale[BENCH_K * 4] __attribute__((aligned(4)));
+
+// Operands of the core kernel, standing in for post-ops on the cores
+PI_L1 static uint8_t bench_a[BENCH_KERNEL_SIZE];
+PI_L1 static uint8_t bench_b[BENCH_KERNEL_SIZE];
+
+static int bench_cores_done[BENCH_MAX_REPS];
+
+static nnx_dev_t bench_dev = NNX_DEV_DEFAULT;
+
+static const uint8_t bench_max_stalls[] = { 0, 1, 4, 16, 64, 255 };
+
+#define BENCH_N_MAX_STALLS (sizeof(bench_max_stalls) / sizeof(bench_max_stalls[0]))
+
+// Saturating add over the core's share of the operands
+static void bench_kernel(void *args) {
+    const int chunk = BENCH_KERNEL_SIZE / pi_cl_team_nb_cores();
+    const int start = pi_core_id() * chunk;
+
+    for (int pass = 0; pass < BENCH_KERNEL_PASSES; pass++) {
+        for (int i = start; i < start + chunk; i++) {
+            const int sum = bench_a[i] + bench_b[i];
+            bench_a[i] = sum > 255 ? 255 : sum;
+        }
+    }
+}
+
+static void bench_task(nnx_task_t *task) {
+    const nnx_feature_t input = {
+        .data = bench_input,
+        .height = BENCH_H,
+        .width = BENCH_W,
+        .depth = BENCH_K,
+        .bitwidth = featureBitwidth8Bit
+    };
+
+    const nnx_feature_t output = {
+        .data = bench_output,
+        .height = BENCH_H,
+        .width = BENCH_W,
+        .depth = BENCH_K,
+        .bitwidth = featureBitwidth8Bit
+    };
+
+    bench_conv_task(&bench_dev, task, 1, 0, input, output, bench_weights);
+    task->scale_ptr = (uint32_t)bench_scale;
+}
+
+void bench(void *args) {
+    nnx_task_t task;
+    bench_result_t ne16, cores, both;
+    bench_stat_t cores_done;
+    nnx_arbitration_t best = NNX_ARBITRATION_DEFAULT;
+    float best_speedup = 0.0f;
+
+    nnx_init(&bench_dev);
+    bench_task(&task);
+    bench_calibrate(BENCH_REPS);
+
+    printf("TCDM arbitration sweep (%d cores, median cycles):\n"
+           "%-6s %-10s %10s %10s %14s %14s %8s\n",
+           NUM_CORES, "owner", "max stall", "ne16", "cores", "cores (both)", "total (both)", "speedup");
+
+    for (int owner = priorityOwnerCore; owner <= priorityOwnerNe16; owner++) {
+        for (int i = 0; i < BENCH_N_MAX_STALLS; i++) {
+            const nnx_arbitration_t arbitration = {
+                .owner = owner,
+                .max_stall = bench_max_stalls[i]
+            };
+            nnx_set_arbitration(&bench_dev, arbitration);
+
+            BENCH_MEASURE(ne16, BENCH_REPS, { nnx_acquire(&bench_dev); nnx_offload(&bench_dev, &task); }, nnx_run(&bench_dev), (void)0);
+
+            BENCH_MEASURE(cores, BENCH_REPS, (void)0, pi_cl_team_fork(NUM_CORES, bench_kernel, NULL), (void)0);
+
+            BENCH_MEASURE(both, BENCH_REPS, { nnx_acquire(&bench_dev); nnx_offload(&bench_dev, &task); },
+                          {
+                              nnx_run_async(&bench_dev);
+                              pi_cl_team_fork(NUM_CORES, bench_kernel, NULL);
+                              bench_cores_done[bench_i] = pi_perf_read(PI_PERF_CYCLES);
+                              nnx_wait_empty(&bench_dev);
+                          }, (void)0);
+            cores_done = bench_stat(bench_cores_done, BENCH_REPS, bench_offset.cycles.median);
+
+            // Speedup of running both side by side over running them one after the other
+            const float speedup = (float)(ne16.cycles.median + cores.cycles.median) / (float)both.cycles.median;
+
+            printf("%-6s %-10d %10d %10d %14d %14d %8.2f\n",
+                   owner == priorityOwnerNe16 ? "ne16" : "core", arbitration.max_stall,
+                   ne16.cycles.median, cores.cycles.median, cores_done.median, both.cycles.median, speedup);
+
+            if (speedup > best_speedup) {
+                best_speedup = speedup;
+                best = arbitration;
+            }
+        }
+    }
+
+    printf("\nBest combined throughput: owner %s, max stall %d (speedup %.2f)\n",
+           best.owner == priorityOwnerNe16 ? "ne16" : "core", best.max_stall, best_speedup);
+
+    nnx_term(&bench_dev);
+}
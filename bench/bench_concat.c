@@ -0,0 +1,133 @@
+#include <pmsis.h>
+
+#include "pulp_nnx.h"
+#include "bench.h"
+#include "bench_util.h"
+
+#define BENCH_REPS (16)
+
+// Two 1x1 32->32 12x12 branches concatenated along the channels, as in an
+// Inception block
+#define BENCH_H (12)
+#define BENCH_W (12)
+#define BENCH_K_IN (32)
+#define BENCH_K_BRANCH (32)
+#define BENCH_N_BRANCHES (2)
+#define BENCH_K_CONCAT (BENCH_N_BRANCHES * BENCH_K_BRANCH)
+
+#define BENCH_WEIGHTS_SIZE (BENCH_K_BRANCH * (BENCH_K_IN / 16) * 8 * 2)
+
+PI_L1 static uint8_t bench_input[BENCH_H * BENCH_W * BENCH_K_IN] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_weights[BENCH_N_BRANCHES][BENCH_WEIGHTS_SIZE] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_scale[BENCH_N_BRANCHES][BENCH_K_BRANCH * 4] __attribute__((aligned(4)));
+
+// Dense branch outputs, only needed when the concatenation is copied
+PI_L1 static uint8_t bench_branch[BENCH_N_BRANCHES][BENCH_H * BENCH_W * BENCH_K_BRANCH] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_concat_copy[BENCH_H * BENCH_W * BENCH_K_CONCAT] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_concat_view[BENCH_H * BENCH_W * BENCH_K_CONCAT] __attribute__((aligned(4)));
+
+static nnx_dev_t bench_dev = NNX_DEV_DEFAULT;
+
+static const nnx_feature_t bench_concat_copy_tensor = {
+    .data = bench_concat_copy,
+    .height = BENCH_H,
+    .width = BENCH_W,
+    .depth = BENCH_K_CONCAT,
+    .bitwidth = featureBitwidth8Bit
+};
+
+static const nnx_feature_t bench_concat_view_tensor = {
+    .data = bench_concat_view,
+    .height = BENCH_H,
+    .width = BENCH_W,
+    .depth = BENCH_K_CONCAT,
+    .bitwidth = featureBitwidth8Bit
+};
+
+static void bench_task(nnx_task_t *task, const int branch, const nnx_feature_t output) {
+    const nnx_feature_t input = {
+        .data = bench_input,
+        .height = BENCH_H,
+        .width = BENCH_W,
+        .depth = BENCH_K_IN,
+        .bitwidth = featureBitwidth8Bit
+    };
+
+    bench_conv_task(&bench_dev, task, 1, 0, input, output, bench_weights[branch]);
+    task->scale_ptr = (uint32_t)bench_scale[branch];
+}
+
+static void bench_run_branches(nnx_task_t *tasks) {
+    for (int b = 0; b < BENCH_N_BRANCHES; b++) {
+        nnx_acquire(&bench_dev);
+        nnx_offload(&bench_dev, &tasks[b]);
+        nnx_run_async(&bench_dev);
+    }
+    nnx_wait_empty(&bench_dev);
+}
+
+// Copy kernel the concatenation needs without views, pixels are split
+// between the cores
+static void bench_concat_kernel(void *args) {
+    const int n_pixels = BENCH_H * BENCH_W;
+    const int chunk = DIVNCEIL(n_pixels, pi_cl_team_nb_cores());
+    const int start = pi_core_id() * chunk;
+    const int end = start + chunk < n_pixels ? start + chunk : n_pixels;
+
+    for (int p = start; p < end; p++)
+        for (int b = 0; b < BENCH_N_BRANCHES; b++)
+            for (int k = 0; k < BENCH_K_BRANCH; k++)
+                bench_concat_copy[p * BENCH_K_CONCAT + b * BENCH_K_BRANCH + k] = bench_branch[b][p * BENCH_K_BRANCH + k];
+}
+
+void bench(void *args) {
+    nnx_task_t copy_tasks[BENCH_N_BRANCHES], view_tasks[BENCH_N_BRANCHES];
+    bench_result_t copy, view;
+
+    for (int i = 0; i < sizeof(bench_input); i++)
+        bench_input[i] = i * 7;
+    for (int b = 0; b < BENCH_N_BRANCHES; b++) {
+        for (int i = 0; i < BENCH_WEIGHTS_SIZE; i++)
+            bench_weights[b][i] = (i + b) * 13;
+        for (int i = 0; i < BENCH_K_BRANCH * 4; i++)
+            bench_scale[b][i] = i % 4 == 0 ? 1 : 0;
+    }
+
+    nnx_init(&bench_dev);
+
+    for (int b = 0; b < BENCH_N_BRANCHES; b++) {
+        const nnx_feature_t branch = {
+            .data = bench_branch[b],
+            .height = BENCH_H,
+            .width = BENCH_W,
+            .depth = BENCH_K_BRANCH,
+            .bitwidth = featureBitwidth8Bit
+        };
+        bench_task(&copy_tasks[b], b, branch);
+
+        // Every branch writes straight into its channels of the concatenation
+        bench_task(&view_tasks[b], b, nnx_view_channels(&bench_concat_view_tensor, b * BENCH_K_BRANCH, BENCH_K_BRANCH));
+    }
+
+    bench_calibrate(BENCH_REPS);
+
+    BENCH_MEASURE(copy, BENCH_REPS, (void)0,
+                  {
+                      bench_run_branches(copy_tasks);
+                      pi_cl_team_fork(NUM_CORES, bench_concat_kernel, NULL);
+                  }, (void)0);
+
+    BENCH_MEASURE(view, BENCH_REPS, (void)0, bench_run_branches(view_tasks), (void)0);
+
+    int n_err = 0;
+    for (int i = 0; i < sizeof(bench_concat_view); i++)
+        n_err += bench_concat_view[i] != bench_concat_copy[i];
+
+    bench_print_header("Channel concatenation of 2 branches (1x1 32->32 12x12)");
+    bench_print("conv + copy", "12x12x64", copy);
+    bench_print("conv into views", "12x12x64", view);
+    printf("Saved %d cycles, outputs %s\n", copy.cycles.median - view.cycles.median,
+           n_err == 0 ? "match" : "differ");
+
+    nnx_term(&bench_dev);
+}
@@ -0,0 +1,122 @@
+#include <pmsis.h>
+
+#include "pulp_nnx.h"
+#include "bench.h"
+#include "bench_util.h"
+
+#define BENCH_REPS (8)
+
+// 3x3 32->32 12x12 layer in L1 split into a varying number of groups
+#define BENCH_H (12)
+#define BENCH_W (12)
+#define BENCH_K (32)
+
+// Packed weights never exceed those of the dense layer
+#define BENCH_WEIGHTS_SIZE (BENCH_K * DIVNCEIL(BENCH_K, 16) * 8 * 3 * 3 * 2)
+
+PI_L1 static uint8_t bench_input[(BENCH_H + 2) * (BENCH_W + 2) * BENCH_K] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_output[BENCH_H * BENCH_W * BENCH_K] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_weights[BENCH_WEIGHTS_SIZE] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_scale[BENCH_K * 4] __attribute__((aligned(4)));
+
+static nnx_dev_t bench_dev = NNX_DEV_DEFAULT;
+
+static const int bench_groups[] = { 1, 2, 4, 8, 16, 32 };
+
+#define BENCH_N_GROUPS (sizeof(bench_groups) / sizeof(bench_groups[0]))
+
+// Same rule as Ne16.groups_per_job in the generator
+static int bench_groups_per_job(const int groups) {
+    const int k_group = BENCH_K / groups;
+    int n = k_group < 16 ? 16 / k_group : 1;
+    while (groups % n != 0)
+        n--;
+    return n;
+}
+
+static const nnx_feature_t bench_input_tensor = {
+    .data = bench_input,
+    .height = BENCH_H + 2,
+    .width = BENCH_W + 2,
+    .depth = BENCH_K,
+    .bitwidth = featureBitwidth8Bit
+};
+
+static const nnx_feature_t bench_output_tensor = {
+    .data = bench_output,
+    .height = BENCH_H,
+    .width = BENCH_W,
+    .depth = BENCH_K,
+    .bitwidth = featureBitwidth8Bit
+};
+
+static nnx_error_code bench_conv(nnx_task_t *task, nnx_grouped_conv_t *conv, const int n_jobs) {
+    const int k_job = BENCH_K / n_jobs;
+
+    const nnx_error_code err = bench_conv_task(&bench_dev, task, 3, 0,
+                                               nnx_view_channels(&bench_input_tensor, 0, k_job),
+                                               nnx_view_channels(&bench_output_tensor, 0, k_job),
+                                               bench_weights);
+
+    const nnx_grouped_conv_t grouped = {
+        .dev = &bench_dev,
+        .task = task,
+        .input = bench_input_tensor,
+        .output = bench_output_tensor,
+        .weights = bench_weights,
+        .weights_job_size = k_job * DIVNCEIL(k_job, 16) * 8 * 3 * 3 * 2,
+        .scale = bench_scale,
+        .scale_bytes = 4,
+        .n_jobs = n_jobs
+    };
+    *conv = grouped;
+    return err;
+}
+
+// Median cycles of the layer run as n_jobs jobs, 0 if the jobs' channels
+// are not word aligned or the HAL rejects the job
+static int bench_run(const int n_jobs) {
+    nnx_task_t task;
+    nnx_grouped_conv_t conv;
+    bench_result_t result;
+
+    if ((BENCH_K / n_jobs) % 4 != 0)
+        return 0;
+
+    if (bench_conv(&task, &conv, n_jobs) != success)
+        return 0;
+
+    BENCH_MEASURE(result, BENCH_REPS, (void)0, nnx_run_grouped(&conv), (void)0);
+    return result.cycles.median;
+}
+
+void bench(void *args) {
+    nnx_init(&bench_dev);
+    bench_calibrate(BENCH_REPS);
+
+    printf("Grouped 3x3 32->32 12x12 convolution (median cycles):\n"
+           "%-7s %10s %12s %12s %10s %12s %12s\n",
+           "groups", "MAC", "per group", "MAC/cycle", "groups/job", "batched", "MAC/cycle");
+
+    for (int i = 0; i < BENCH_N_GROUPS; i++) {
+        const int groups = bench_groups[i];
+        const int groups_per_job = bench_groups_per_job(groups);
+        const int mac = BENCH_H * BENCH_W * BENCH_K * 3 * 3 * (BENCH_K / groups);
+
+        // One job per group, then the groups batched into block diagonal jobs
+        const int per_group = bench_run(groups);
+        const int batched = bench_run(groups / groups_per_job);
+
+        if (per_group > 0)
+            printf("%-7d %10d %12d %12.2f", groups, mac, per_group, (float)mac / per_group);
+        else
+            printf("%-7d %10d %12s %12s", groups, mac, "-", "-");
+
+        if (batched > 0)
+            printf(" %10d %12d %12.2f\n", groups_per_job, batched, (float)mac / batched);
+        else
+            printf(" %10d %12s %12s\n", groups_per_job, "-", "-");
+    }
+
+    nnx_term(&bench_dev);
+}
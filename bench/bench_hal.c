@@ -0,0 +1,155 @@
+#include <pmsis.h>
+
+#include "pulp_nnx.h"
+#include "bench.h"
+#include "bench_util.h"
+
+#define BENCH_REPS (64)
+
+typedef struct {
+    const char *name;
+    int kernel_shape;
+    int depthwise;
+    int k_in;
+    int k_out;
+    int h_out;
+    int w_out;
+} bench_shape_t;
+
+static const bench_shape_t bench_shapes[] = {
+    { "1x1 16->32 3x3",   1, 0, 16, 32,  3,  3 },
+    { "1x1 64->64 15x15", 1, 0, 64, 64, 15, 15 },
+    { "3x3 16->32 3x3",   3, 0, 16, 32,  3,  3 },
+    { "3x3 32->32 6x6",   3, 0, 32, 32,  6,  6 },
+    { "3x3dw 32 12x12",   3, 1, 32, 32, 12, 12 }
+};
+
+#define BENCH_N_SHAPES (sizeof(bench_shapes) / sizeof(bench_shapes[0]))
+
+static nnx_dev_t bench_dev = NNX_DEV_DEFAULT;
+
+// Sized for the largest shape, the contents do not affect the timing
+PI_L1 static uint8_t bench_input[15 * 15 * 64] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_output[15 * 15 * 64] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_weights[32 * 2 * 8 * 3 * 3 * 2] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_scale[64 * 4] __attribute__((aligned(4)));
+
+static nnx_feature_t bench_nnx_input(const bench_shape_t *shape) {
+    const nnx_feature_t input = {
+        .data = bench_input,
+        .height = shape->h_out + shape->kernel_shape - 1,
+        .width = shape->w_out + shape->kernel_shape - 1,
+        .depth = shape->k_in,
+        .bitwidth = featureBitwidth8Bit
+    };
+    return input;
+}
+
+static nnx_feature_t bench_nnx_output(const bench_shape_t *shape) {
+    const nnx_feature_t output = {
+        .data = bench_output,
+        .height = shape->h_out,
+        .width = shape->w_out,
+        .depth = shape->k_out,
+        .bitwidth = featureBitwidth8Bit
+    };
+    return output;
+}
+
+static nnx_error_code bench_conv(nnx_task_t *task, const bench_shape_t *shape) {
+    const nnx_feature_t input = bench_nnx_input(shape);
+    const nnx_feature_t output = bench_nnx_output(shape);
+    const nnx_weights_t weights = bench_conv_weights(shape->kernel_shape, shape->depthwise, &input, &output, bench_weights);
+
+    if (shape->kernel_shape == 1)
+        return nnx_conv_1x1(&bench_dev, &task->cfg, weights, input, output, bench_padding, 1);
+    else if (shape->depthwise)
+        return nnx_conv_3x3_dw(&bench_dev, &task->cfg, weights, input, output, bench_padding, 1);
+    else
+        return nnx_conv_3x3(&bench_dev, &task->cfg, weights, input, output, bench_padding, 1);
+}
+
+static void bench_task(nnx_task_t *task, const bench_shape_t *shape) {
+    bench_conv_task(&bench_dev, task, shape->kernel_shape, shape->depthwise,
+                    bench_nnx_input(shape), bench_nnx_output(shape), bench_weights);
+    task->scale_ptr = (uint32_t)bench_scale;
+}
+
+static const char *bench_conv_name(const bench_shape_t *shape) {
+    if (shape->kernel_shape == 1)
+        return "nnx_conv_1x1";
+    else if (shape->depthwise)
+        return "nnx_conv_3x3_dw";
+    else
+        return "nnx_conv_3x3";
+}
+
+void bench(void *args) {
+    nnx_task_t task;
+    bench_result_t result;
+
+    nnx_init(&bench_dev);
+
+    bench_calibrate(BENCH_REPS);
+
+    bench_print_header("Task configuration");
+
+    BENCH_MEASURE(result, BENCH_REPS, (void)0, nnx_task_init(&task), (void)0);
+    bench_print("nnx_task_init", "-", result);
+
+    for (int i = 0; i < BENCH_N_SHAPES; i++) {
+        const bench_shape_t *shape = &bench_shapes[i];
+        BENCH_MEASURE(result, BENCH_REPS, nnx_task_init(&task), bench_conv(&task, shape), (void)0);
+        bench_print(bench_conv_name(shape), shape->name, result);
+    }
+
+    BENCH_MEASURE(result, BENCH_REPS, nnx_task_init(&task), nnx_norm_quant(&task.cfg, bench_norm, bench_quant), (void)0);
+    bench_print("nnx_norm_quant", "-", result);
+
+    BENCH_MEASURE(result, BENCH_REPS, nnx_task_init(&task), nnx_pad_input(&task.cfg, bench_padding), (void)0);
+    bench_print("nnx_pad_input", "-", result);
+
+    printf("\n");
+    bench_print_header("Job control");
+
+    // Every acquired context is released with a soft clear
+    bench_task(&task, &bench_shapes[0]);
+
+    BENCH_MEASURE(result, BENCH_REPS, (void)0, nnx_acquire(&bench_dev), nnx_soft_clear(&bench_dev));
+    bench_print("nnx_acquire", "-", result);
+
+    BENCH_MEASURE(result, BENCH_REPS, nnx_acquire(&bench_dev), nnx_offload(&bench_dev, &task), nnx_soft_clear(&bench_dev));
+    bench_print("nnx_offload", "-", result);
+
+    BENCH_MEASURE(result, BENCH_REPS, nnx_acquire(&bench_dev), nnx_offload_ptr(&bench_dev, &task), nnx_soft_clear(&bench_dev));
+    bench_print("nnx_offload_ptr", "-", result);
+
+    for (int i = 0; i < BENCH_N_SHAPES; i++) {
+        const bench_shape_t *shape = &bench_shapes[i];
+        bench_result_t event, busy;
+
+        bench_task(&task, shape);
+
+        BENCH_MEASURE(result, BENCH_REPS, { nnx_acquire(&bench_dev); nnx_offload(&bench_dev, &task); },
+                      nnx_run_async(&bench_dev), nnx_wait_empty(&bench_dev));
+        bench_print("trigger", shape->name, result);
+
+        // The difference between sleeping on the event and polling the
+        // status is the cost of waking up the core
+        BENCH_MEASURE(event, BENCH_REPS, { nnx_acquire(&bench_dev); nnx_offload(&bench_dev, &task); nnx_run_async(&bench_dev); },
+                      nnx_wait_empty(&bench_dev), (void)0);
+        bench_print("completion (event)", shape->name, event);
+
+        BENCH_MEASURE(busy, BENCH_REPS, { nnx_acquire(&bench_dev); nnx_offload(&bench_dev, &task); nnx_run_async(&bench_dev); },
+                      nnx_busywait(&bench_dev), (void)0);
+        bench_print("completion (busywait)", shape->name, busy);
+
+        printf("%-24s %-20s %8d cycles (median)\n", "wake-up latency", shape->name,
+               event.cycles.median - busy.cycles.median);
+
+        BENCH_MEASURE(result, BENCH_REPS, { nnx_acquire(&bench_dev); nnx_offload(&bench_dev, &task); }, nnx_run(&bench_dev), (void)0);
+        bench_print("nnx_run", shape->name, result);
+    }
+
+    nnx_term(&bench_dev);
+}
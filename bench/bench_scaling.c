@@ -0,0 +1,152 @@
+#include <pmsis.h>
+
+#include "pulp_nnx.h"
+#include "bench.h"
+#include "bench_util.h"
+
+#define BENCH_REPS (8)
+#define BENCH_MAX_PARTS (4)
+
+// 3x3 16->32 24x24 layer in L2, tiled into 6x6x32 output tiles
+#define BENCH_H (24)
+#define BENCH_W (24)
+#define BENCH_K_IN (16)
+#define BENCH_K_OUT (32)
+#define BENCH_TILE (6)
+
+#define BENCH_WEIGHTS_SIZE (BENCH_K_OUT * 8 * 3 * 3 * 2)
+#define BENCH_TILE_INPUT_SIZE ((BENCH_TILE + 2) * (BENCH_TILE + 2) * BENCH_K_IN)
+#define BENCH_TILE_OUTPUT_SIZE (BENCH_TILE * BENCH_TILE * BENCH_K_OUT)
+
+// NE16 instances reachable from this cluster. Further instances are listed
+// here with their own base address and event line.
+static nnx_dev_t bench_devices[] = {
+    NNX_DEV_DEFAULT
+};
+
+#define BENCH_N_DEVICES (sizeof(bench_devices) / sizeof(bench_devices[0]))
+
+PI_L2 static uint8_t bench_input[(BENCH_H + 2) * (BENCH_W + 2) * BENCH_K_IN] __attribute__((aligned(4)));
+PI_L2 static uint8_t bench_output[BENCH_H * BENCH_W * BENCH_K_OUT] __attribute__((aligned(4)));
+PI_L2 static uint8_t bench_weights[BENCH_WEIGHTS_SIZE] __attribute__((aligned(4)));
+PI_L2 static uint8_t bench_scale[BENCH_K_OUT * 4] __attribute__((aligned(4)));
+PI_L2 static uint8_t bench_reference[BENCH_H * BENCH_W * BENCH_K_OUT];
+
+// One set of L1 buffers per context of every device
+PI_L1 static uint8_t bench_tile_input[BENCH_N_DEVICES][NNX_CONTEXT_SIZE][BENCH_TILE_INPUT_SIZE] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_tile_weights[BENCH_N_DEVICES][NNX_CONTEXT_SIZE][BENCH_WEIGHTS_SIZE] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_tile_scale[BENCH_N_DEVICES][NNX_CONTEXT_SIZE][BENCH_K_OUT * 4] __attribute__((aligned(4)));
+PI_L1 static uint8_t bench_tile_output[BENCH_N_DEVICES][NNX_CONTEXT_SIZE][BENCH_TILE_OUTPUT_SIZE] __attribute__((aligned(4)));
+
+static nnx_task_t bench_tasks[BENCH_N_DEVICES];
+static nnx_tiled_layer_t bench_layers[BENCH_N_DEVICES];
+
+static const nnx_tile_plan_t bench_plan = {
+    .height = BENCH_TILE,
+    .width = BENCH_TILE,
+    .depth = BENCH_K_OUT,
+    .order = tileOrderSpatialOuter
+};
+
+// Every device gets its own configuration of the same layer
+static void bench_layer(const int d) {
+    nnx_dev_t *dev = &bench_devices[d];
+    nnx_task_t *task = &bench_tasks[d];
+    nnx_tiled_layer_t *layer = &bench_layers[d];
+
+    const nnx_feature_t input = {
+        .data = bench_input,
+        .height = BENCH_H + 2,
+        .width = BENCH_W + 2,
+        .depth = BENCH_K_IN,
+        .bitwidth = featureBitwidth8Bit
+    };
+
+    const nnx_feature_t output = {
+        .data = bench_output,
+        .height = BENCH_H,
+        .width = BENCH_W,
+        .depth = BENCH_K_OUT,
+        .bitwidth = featureBitwidth8Bit
+    };
+
+    bench_conv_task(dev, task, 3, 0, input, output, bench_weights);
+
+    const nnx_tiled_layer_t tiled = {
+        .dev = dev,
+        .task = task,
+        .input = input,
+        .output = output,
+        .weights = bench_conv_weights(3, 0, &input, &output, bench_weights),
+        .scale = bench_scale,
+        .scale_bytes = 4,
+        .buffer = {
+            { bench_tile_input[d][0], bench_tile_weights[d][0], bench_tile_scale[d][0], bench_tile_output[d][0] },
+            { bench_tile_input[d][1], bench_tile_weights[d][1], bench_tile_scale[d][1], bench_tile_output[d][1] }
+        }
+    };
+    *layer = tiled;
+}
+
+// Runs the n parts of the layer on one device over a cleared output. The
+// output matches the whole layer only if every tile belongs to exactly one
+// part.
+static int bench_check_parts(const int n) {
+    for (int i = 0; i < sizeof(bench_output); i++)
+        bench_output[i] = 0;
+
+    for (int p = 0; p < n; p++)
+        nnx_run_tiled_part(&bench_layers[0], bench_plan, p, n);
+
+    int n_err = 0;
+    for (int i = 0; i < sizeof(bench_output); i++)
+        n_err += bench_output[i] != bench_reference[i];
+    return n_err;
+}
+
+void bench(void *args) {
+    bench_result_t sequential, parallel, single;
+
+    for (int d = 0; d < BENCH_N_DEVICES; d++) {
+        nnx_init(&bench_devices[d]);
+        bench_layer(d);
+    }
+
+    bench_calibrate(BENCH_REPS);
+
+    BENCH_MEASURE(single, BENCH_REPS, (void)0, nnx_run_tiled(&bench_layers[0], bench_plan), (void)0);
+
+    for (int i = 0; i < sizeof(bench_output); i++)
+        bench_reference[i] = bench_output[i];
+
+    printf("Multi-device scaling (%d devices available, median cycles):\n"
+           "%-6s %14s %14s %8s %10s %8s\n",
+           BENCH_N_DEVICES, "parts", "one device", "n devices", "speedup", "efficiency", "output");
+
+    for (int n = 1; n <= BENCH_MAX_PARTS; n++) {
+        // The parts run back to back on a single device. The difference to
+        // the whole layer is the cost of splitting, e.g. the lost buffer reuse.
+        BENCH_MEASURE(sequential, BENCH_REPS, (void)0,
+                      {
+                          for (int p = 0; p < n; p++)
+                              nnx_run_tiled_part(&bench_layers[0], bench_plan, p, n);
+                      }, (void)0);
+
+        // nnx_run_tiled_multi gives every device the same part as here
+        const char *parts_output = bench_check_parts(n) == 0 ? "match" : "differ";
+
+        if (n > BENCH_N_DEVICES || n > NUM_CORES) {
+            printf("%-6d %14d %14s %8s %10s %8s\n", n, sequential.cycles.median, "-", "-", "-", parts_output);
+            continue;
+        }
+
+        BENCH_MEASURE(parallel, BENCH_REPS, (void)0, nnx_run_tiled_multi(bench_layers, n, bench_plan), (void)0);
+
+        const float speedup = (float)single.cycles.median / (float)parallel.cycles.median;
+        printf("%-6d %14d %14d %8.2f %9.0f%% %8s\n", n, sequential.cycles.median, parallel.cycles.median,
+               speedup, 100.0f * speedup / n, parts_output);
+    }
+
+    for (int d = 0; d < BENCH_N_DEVICES; d++)
+        nnx_term(&bench_devices[d]);
+}
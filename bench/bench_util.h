@@ -0,0 +1,155 @@
+#ifndef __BENCH_UTIL_H__
+#define __BENCH_UTIL_H__
+
+#include <pmsis.h>
+
+#include "pulp_nnx.h"
+
+#define BENCH_MAX_REPS (128)
+
+typedef struct {
+    int min;
+    int median;
+    int max;
+} bench_stat_t;
+
+typedef struct {
+    bench_stat_t cycles;
+    bench_stat_t instr;
+} bench_result_t;
+
+static int bench_cycles[BENCH_MAX_REPS];
+static int bench_instr[BENCH_MAX_REPS];
+
+// Cost of the measurement itself, subtracted from every result
+static bench_result_t bench_offset;
+
+static bench_stat_t bench_stat(int *values, const int n, const int offset) {
+    for (int i = 1; i < n; i++) {
+        const int value = values[i];
+        int j = i - 1;
+        for (; j >= 0 && values[j] > value; j--)
+            values[j + 1] = values[j];
+        values[j + 1] = value;
+    }
+
+    const bench_stat_t stat = {
+        .min = values[0] - offset,
+        .median = values[n / 2] - offset,
+        .max = values[n - 1] - offset
+    };
+    return stat;
+}
+
+static void bench_perf_start() {
+    pi_perf_conf((1 << PI_PERF_CYCLES) | (1 << PI_PERF_INSTR));
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+}
+
+// Number of repetitions that fit the sample buffers, reports a clamped count
+static int bench_reps(const int reps) {
+    if (reps <= BENCH_MAX_REPS)
+        return reps;
+    printf("Warning: %d repetitions requested, measuring only BENCH_MAX_REPS = %d\n", reps, BENCH_MAX_REPS);
+    return BENCH_MAX_REPS;
+}
+
+// Runs code reps times and measures only the code, pre and post run around
+// every repetition outside of the measurement. At most BENCH_MAX_REPS
+// repetitions are measured.
+#define BENCH_MEASURE(result, reps, pre, code, post)                               \
+    do {                                                                           \
+        const int bench_n = bench_reps(reps);                                      \
+        for (int bench_i = 0; bench_i < bench_n; bench_i++) {                      \
+            pre;                                                                   \
+            bench_perf_start();                                                    \
+            code;                                                                  \
+            pi_perf_stop();                                                        \
+            bench_cycles[bench_i] = pi_perf_read(PI_PERF_CYCLES);                  \
+            bench_instr[bench_i] = pi_perf_read(PI_PERF_INSTR);                    \
+            post;                                                                  \
+        }                                                                          \
+        (result).cycles = bench_stat(bench_cycles, bench_n, bench_offset.cycles.median); \
+        (result).instr = bench_stat(bench_instr, bench_n, bench_offset.instr.median);    \
+    } while (0)
+
+static void bench_calibrate(const int reps) {
+    bench_result_t offset;
+    BENCH_MEASURE(offset, reps, (void)0, (void)0, (void)0);
+    bench_offset = offset;
+}
+
+static void bench_print_header(const char *title) {
+    printf("%s:\n"
+           "%-24s %-20s %26s %26s\n",
+           title, "primitive", "shape", "cycles (min/median/max)", "instr (min/median/max)");
+}
+
+static void bench_print(const char *primitive, const char *shape, const bench_result_t result) {
+    printf("%-24s %-20s %8d/%8d/%8d %8d/%8d/%8d\n",
+           primitive, shape,
+           result.cycles.min, result.cycles.median, result.cycles.max,
+           result.instr.min, result.instr.median, result.instr.max);
+}
+
+// Requantization shared by the benchmarks, the contents of the tensors do not
+// affect the timing
+static const nnx_norm_t bench_norm = {
+    .mode  = normMode32Bit,
+    .flag_bias  = FLAG_UNUSED,
+    .flag_shift = FLAG_UNUSED
+};
+
+static const nnx_quant_t bench_quant = {
+    .shift_amount = 8,
+    .mode = quantMode8Bit,
+    .function = quantFunctionRelu,
+    .flag_rounding = FLAG_UNUSED
+};
+
+static const nnx_padding_t bench_padding = { 0 };
+
+// Weights of a ks x ks layer from input to output, depthwise layers have
+// weights of depth 1
+static nnx_weights_t bench_conv_weights(const int ks, const int depthwise, const nnx_feature_t *input,
+                                        const nnx_feature_t *output, uint8_t *data) {
+    const nnx_weights_t weights = {
+        .data = data,
+        .height = ks,
+        .width = ks,
+        .depth = depthwise ? 1 : input->depth,
+        .n_weights = output->depth,
+        .bitwidth = 8,
+        .offset_factor = 0,
+        .offset_mode = weightOffsetModeLayerWise
+    };
+    return weights;
+}
+
+// Configures the task as an unpadded stride 1 ks x ks layer with the shared
+// requantization and points it at the input, output and weights. The scale
+// pointer is left to the caller.
+static nnx_error_code bench_conv_task(nnx_dev_t *dev, nnx_task_t *task, const int ks, const int depthwise,
+                                      const nnx_feature_t input, const nnx_feature_t output, uint8_t *weights) {
+    const nnx_weights_t nnx_weights = bench_conv_weights(ks, depthwise, &input, &output, weights);
+    nnx_error_code err;
+
+    nnx_task_init(task);
+    if (ks == 1)
+        err = nnx_conv_1x1(dev, &task->cfg, nnx_weights, input, output, bench_padding, 1);
+    else if (depthwise)
+        err = nnx_conv_3x3_dw(dev, &task->cfg, nnx_weights, input, output, bench_padding, 1);
+    else
+        err = nnx_conv_3x3(dev, &task->cfg, nnx_weights, input, output, bench_padding, 1);
+    nnx_norm_quant(&task->cfg, bench_norm, bench_quant);
+    nnx_pad_input(&task->cfg, bench_padding);
+
+    task->infeat_ptr = (uint32_t)input.data;
+    task->outfeat_ptr = (uint32_t)output.data;
+    task->weights_ptr = (uint32_t)weights;
+    return err;
+}
+
+#endif  // __BENCH_UTIL_H__
@@ -0,0 +1,193 @@
+# cache.py
+# Luka Macan <luka.macan@fer.hr>
+#
+# Copyright (C) 2022 University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import os
+import inspect
+import hashlib
+import functools
+import numpy as np
+
+CACHE_DIR = '.cache'
+
+# Entries beyond this size are evicted, least recently used first
+CACHE_MAX_BYTES = 256 * 1024 * 1024
+
+
+@functools.lru_cache(maxsize=None)
+def code_digest(*objects):
+    """ Digest of the source of functions or classes
+
+    Part of every key, so entries produced by an older packer or renderer are
+    never reused.
+    """
+    return hashlib.sha1(''.join(inspect.getsource(o) for o in objects).encode()).hexdigest()
+
+
+def data_bytes(data):
+    """ Canonical bytes of a tensor, an array or a bytes object """
+    if isinstance(data, (bytes, bytearray)):
+        return bytes(data)
+    if hasattr(data, 'numpy'):
+        data = data.numpy()
+    return np.ascontiguousarray(data).astype('<i8').tobytes()
+
+
+class ContentCache:
+    """ On-disk cache addressed by a hash of everything the entry depends on
+
+    Holds packed weights and rendered vectors. Nothing is ever invalidated:
+    a change in the data, the layout or the code producing the entry changes
+    its key. Every unseeded run therefore adds new entries, so prune() evicts
+    the least recently used ones once the directory grows beyond max_bytes.
+    The directory can be deleted at any time.
+    """
+
+    def __init__(self, root=CACHE_DIR, enabled=True, max_bytes=CACHE_MAX_BYTES):
+        self.root = root
+        self.enabled = enabled
+        self.max_bytes = max_bytes
+        self.hits = {}
+        self.misses = {}
+
+    @staticmethod
+    def key(*parts):
+        sha = hashlib.sha1()
+        for part in parts:
+            sha.update(part if isinstance(part, bytes) else repr(part).encode())
+            sha.update(b'\0')
+        return sha.hexdigest()
+
+    def _path(self, kind, key, ext):
+        return os.path.join(self.root, kind, f'{key}{ext}')
+
+    @staticmethod
+    def _store(path, write):
+        # Sweeps may run several generators at once, so entries are renamed
+        # into place and never seen half written
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        tmp = f'{path}.{os.getpid()}.tmp'
+        write(tmp)
+        os.replace(tmp, path)
+
+    def _count(self, kind, hit):
+        stats = self.hits if hit else self.misses
+        stats[kind] = stats.get(kind, 0) + 1
+
+    @staticmethod
+    def _touch(path):
+        # The modification time orders the entries for the eviction
+        os.utime(path)
+
+    def prune(self):
+        """ Evicts the least recently used entries until the cache fits max_bytes
+
+        Covers every file under the root, so also the autotuner's plans.
+        Returns the number of bytes freed.
+        """
+        if not self.enabled or self.max_bytes is None or not os.path.isdir(self.root):
+            return 0
+
+        entries = []
+        for directory, _, files in os.walk(self.root):
+            for name in files:
+                # Entries of concurrent runs still being written
+                if name.endswith('.tmp'):
+                    continue
+                path = os.path.join(directory, name)
+                try:
+                    stat = os.stat(path)
+                except FileNotFoundError:
+                    continue
+                entries.append((stat.st_mtime, stat.st_size, path))
+
+        total = sum(size for _, size, _ in entries)
+        freed = 0
+        for _, size, path in sorted(entries):
+            if total - freed <= self.max_bytes:
+                break
+            try:
+                os.remove(path)
+            except FileNotFoundError:
+                pass
+            freed += size
+        return freed
+
+    def packed_weights(self, ne16, w, qw, layout, dw):
+        """ Ne16.conv_unroll of w, packed only if it is not in the cache """
+        if not self.enabled:
+            return ne16.conv_unroll(w, qw, layout=layout, dw=dw)
+
+        key = self.key(code_digest(type(ne16)), w.dtype.str, w.shape, data_bytes(w), layout, qw, dw)
+        path = self._path('packed', key, '.npy')
+
+        if os.path.exists(path):
+            self._count('packed', True)
+            self._touch(path)
+            return np.load(path)
+
+        self._count('packed', False)
+        wbytes = ne16.conv_unroll(w, qw, layout=layout, dw=dw)
+
+        def write(tmp):
+            with open(tmp, 'wb') as file:
+                np.save(file, wbytes)
+
+        self._store(path, write)
+        return wbytes
+
+    def text(self, kind, key, render):
+        """ Rendered text stored under key, render() is only called on a miss """
+        if not self.enabled:
+            return render()
+
+        path = self._path(kind, key, '.txt')
+
+        if os.path.exists(path):
+            self._count(kind, True)
+            self._touch(path)
+            with open(path) as file:
+                return file.read()
+
+        self._count(kind, False)
+        text = render()
+
+        def write(tmp):
+            with open(tmp, 'w') as file:
+                file.write(text)
+
+        self._store(path, write)
+        return text
+
+    def report(self):
+        for kind in sorted(set(self.hits) | set(self.misses)):
+            hits, misses = self.hits.get(kind, 0), self.misses.get(kind, 0)
+            print(f'Cache {kind}: {hits}/{hits + misses} hits')
+
+
+def write_if_changed(path, text):
+    """ Writes the file only if its content changes, keeping its timestamp
+    otherwise so that make does not rebuild what depends on it.
+
+    Returns True if the file was written.
+    """
+    if os.path.exists(path):
+        with open(path) as file:
+            if file.read() == text:
+                return False
+
+    with open(path, 'w') as file:
+        file.write(text)
+    return True
@@ -0,0 +1,6 @@
+#ifndef __FUSED_BLOCK_H__
+#define __FUSED_BLOCK_H__
+
+void fused_block(void *args);
+
+#endif  // __FUSED_BLOCK_H__
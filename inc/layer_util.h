@@ -3,27 +3,156 @@
 
 #include "dims.h"
 
+#define INPUT_FRAME_SIZE (INPUT_HEIGHT * INPUT_WIDTH * INPUT_CHANNEL)
+#define OUTPUT_FRAME_SIZE (OUTPUT_HEIGHT * OUTPUT_WIDTH * OUTPUT_CHANNEL)
+
+#define EPILOGUE_NONE    (0)
+#define EPILOGUE_CLIP    (1)
+#define EPILOGUE_ADD     (2)
+#define EPILOGUE_MAXPOOL (3)
+
+// With pooling the layer output is an intermediate tensor
+#if EPILOGUE == EPILOGUE_MAXPOOL
+#define CONV_OUTPUT conv_output
+#else
+#define CONV_OUTPUT output
+#endif
+
+// Compressed weights only exist expanded, one tile at a time, in L1
+#if COMPRESSED_WEIGHTS
+#define WEIGHTS NULL
+#define WEIGHTS_COMPRESSED_SIZE (WEIGHTS_BITMAP_SIZE + WEIGHTS_OFFSETS_SIZE + WEIGHTS_LITERALS_SIZE)
+#else
+#define WEIGHTS weights
+#endif
+
+// Grouped layers run one NE16 job per GROUPS_PER_JOB groups, the same
+// as a dense layer of JOB_CHANNEL_IN -> JOB_CHANNEL_OUT channels
+#define N_JOBS (GROUPS / GROUPS_PER_JOB)
+#define JOB_CHANNEL_IN (INPUT_CHANNEL / N_JOBS)
+#define JOB_CHANNEL_OUT (OUTPUT_CHANNEL / N_JOBS)
+
+// Tile buffer at the offset planned by the generator, e.g. TILE_BUFFER(&arena, INPUT_0)
+#if TILED
+#define TILE_BUFFER(arena, NAME) nnx_arena_place(arena, TILE_##NAME##_OFFSET, TILE_##NAME##_SIZE)
+#endif
+
+#if FUSED_DW_PW
+#define MAC_OPS (OUTPUT_HEIGHT * OUTPUT_WIDTH * INPUT_CHANNEL \
+                 * (WEIGHTS_KERNEL_HEIGHT * WEIGHTS_KERNEL_WIDTH + WEIGHTS_PW_CHANNEL_OUT))
+#else
+#define MAC_OPS (OUTPUT_HEIGHT * OUTPUT_WIDTH * OUTPUT_CHANNEL \
+                 * WEIGHTS_KERNEL_HEIGHT * WEIGHTS_KERNEL_WIDTH * WEIGHTS_CHANNEL_IN)
+#endif
+
 static void layer_info() {
     printf("Layer info:\n"
+           " - batch: %d\n"
            " - input: (%dx%dx%d)\n"
            " - output: (%dx%dx%d)\n"
            " - weights: (%dx%dx%dx%d)\n\n",
+           BATCH,
            INPUT_HEIGHT, INPUT_WIDTH, INPUT_CHANNEL,
            OUTPUT_HEIGHT, OUTPUT_WIDTH, OUTPUT_CHANNEL,
            WEIGHTS_CHANNEL_OUT, WEIGHTS_KERNEL_HEIGHT, WEIGHTS_KERNEL_WIDTH, WEIGHTS_CHANNEL_IN);
+#if RESIDUAL
+    printf("Residual convolution:\n"
+           " - skip streamed in from the output buffer\n"
+           " - skip rescale: %d / 2^%d%s\n\n",
+           SKIP_MULTIPLIER, SKIP_SHIFT,
+           SKIP_MULTIPLIER == 1 && SKIP_SHIFT == 0 ? "" : ", staged by the cores");
+#endif
+#if DILATION > 1
+    printf("Dilated convolution:\n"
+           " - dilation: %d\n"
+           " - jobs: %d, one per phase\n\n",
+           DILATION, DILATION * DILATION);
+#endif
+#if GROUPS > 1
+    printf("Grouped convolution:\n"
+           " - groups: %d\n"
+           " - jobs: %d of %d groups (%d -> %d channels)\n\n",
+           GROUPS, N_JOBS, GROUPS_PER_JOB, JOB_CHANNEL_IN, JOB_CHANNEL_OUT);
+#endif
+#if FUSED_DW_PW
+    printf("Fused pointwise layer info:\n"
+           " - weights: (%dx%dx%dx%d)\n"
+           " - tile: (%dx%d)\n"
+           " - intermediate: %d bytes in L1 (%d bytes unfused)\n\n",
+           WEIGHTS_PW_CHANNEL_OUT, WEIGHTS_PW_KERNEL_HEIGHT, WEIGHTS_PW_KERNEL_WIDTH, WEIGHTS_PW_CHANNEL_IN,
+           FUSED_TILE, FUSED_TILE,
+           FUSED_TILE * FUSED_TILE * INPUT_CHANNEL,
+           OUTPUT_HEIGHT * OUTPUT_WIDTH * INPUT_CHANNEL);
+#endif
+#if TILED
+    printf("Tile plan:\n"
+           " - tile: (%dx%dx%d)\n"
+           " - order: %s outer\n"
+           " - L1 footprint: %d bytes (%d bytes without buffer reuse)\n"
+           " - modelled latency: %d cycles/frame\n\n",
+           TILE_HEIGHT, TILE_WIDTH, TILE_DEPTH,
+           TILE_ORDER == tileOrderSpatialOuter ? "spatial" : "channel",
+           TILE_L1_FOOTPRINT, TILE_L1_UNPLANNED, TILE_MODEL_CYCLES);
+#endif
+#if COMPRESSED_WEIGHTS
+    printf("Compressed weights:\n"
+           " - size: %d bytes (%d bytes raw)\n"
+           " - ratio: %.2f\n\n",
+           WEIGHTS_COMPRESSED_SIZE, WEIGHTS_RAW_SIZE,
+           (float)WEIGHTS_RAW_SIZE / (float)WEIGHTS_COMPRESSED_SIZE);
+#endif
 }
 
-static void layer_stats(const int latency) {
-    const int mac_ops = OUTPUT_HEIGHT * OUTPUT_WIDTH * OUTPUT_CHANNEL
-        * WEIGHTS_KERNEL_HEIGHT * WEIGHTS_KERNEL_WIDTH * WEIGHTS_CHANNEL_IN;
+#if TILED
+// The tile buffers are all placed at planned offsets, so the arena holds
+// exactly the planned footprint
+static void arena_info(const nnx_arena_t *arena) {
+    printf("L1 arena:\n"
+           " - planned tile buffers: %u bytes (%d bytes without buffer reuse)\n\n",
+           arena->size, TILE_L1_UNPLANNED);
+}
+#endif
+
+static void layer_stats(const int setup, const int latency) {
+    const int mac_ops = BATCH * MAC_OPS;
 
     const float perf = (float)mac_ops / (float)latency;
+    const float frame_rate = (float)BATCH * (float)pi_freq_get(PI_FREQ_DOMAIN_CL) / (float)latency;
 
     printf("Layer statistics:\n"
            " - operations: %d MAC\n"
            " - latency: %d cycles\n"
-           " - performance: %.2f MAC/cycle\n\n",
-           mac_ops, latency, perf);
+           " - performance: %.2f MAC/cycle\n"
+           " - throughput: %.2f frames/s\n"
+           " - setup: %d cycles (%d cycles/frame amortized)\n\n",
+           mac_ops, latency, perf, frame_rate, setup, setup / BATCH);
+}
+
+static void session_stats(const int init_term, const int warm, const int cold) {
+    printf("Session statistics:\n"
+           " - init + term: %d cycles/layer\n"
+           " - open session, clock on: %d cycles/layer (saved %d)\n"
+           " - open session, clock gated: %d cycles/layer (saved %d)\n\n",
+           init_term, warm, init_term - warm, cold, init_term - cold);
+}
+
+static void epilogue_stats(const int conv, const int pass, const int fused) {
+    printf("Epilogue statistics:\n"
+           " - separate pass: %d + %d = %d cycles\n"
+           " - per-tile epilogue: %d cycles\n"
+           " - hidden behind the NE16: %d cycles\n\n",
+           conv, pass, conv + pass, fused, conv + pass - fused);
+}
+
+#if COMPRESSED_WEIGHTS
+static void compression_stats(const nnx_tiled_stats_t *stats, const int n_tiles) {
+    printf("Decompression statistics:\n"
+           " - decompression: %d cycles/frame\n"
+           " - NE16 idle before %d/%d tiles\n"
+           " - hidden behind the NE16: %s\n\n",
+           stats->decompress_cycles / BATCH, stats->ne16_idle, n_tiles,
+           stats->ne16_idle == 0 ? "yes" : "no");
 }
+#endif
 
 #endif  // __LAYER_UTIL_H__
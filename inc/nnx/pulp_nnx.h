@@ -21,5 +21,9 @@
 #define __PULP_NNX__
 
 #include "pulp_nnx_hal.h"
+#include "pulp_nnx_rt.h"
+#include "pulp_nnx_trace.h"
+#include "pulp_nnx_alloc.h"
+#include "pulp_nnx_view.h"
 
 #endif /* __PULP_NNX__ */
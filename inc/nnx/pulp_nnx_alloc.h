@@ -0,0 +1,57 @@
+/*
+ * pulp_nnx_alloc.h
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PULP_NNX_ALLOC_H__
+#define __PULP_NNX_ALLOC_H__
+
+#include <stdint.h>
+
+// Buffers handed to the NE16 streamers must be word aligned
+#define NNX_ARENA_ALIGNMENT (4)
+
+// Region of L1 holding buffers that share memory. Buffers are either placed
+// at the offsets planned by the generator (see arena.py) or bump allocated.
+typedef struct {
+    uint8_t *base;
+    uint32_t size;
+    uint32_t top;  // First free byte of the bump allocator
+    uint32_t peak; // Highest end of any buffer handed out
+} nnx_arena_t;
+
+void nnx_arena_init(nnx_arena_t *arena, uint8_t *base, const uint32_t size);
+
+// Returns the planned buffer at offset, or NULL if it does not fit into the
+// arena or is misaligned. Planned buffers may overlap, the plan guarantees
+// that overlapping buffers are never live at the same time.
+void *nnx_arena_place(nnx_arena_t *arena, const uint32_t offset, const uint32_t size);
+
+// Bump allocates size bytes after every buffer handed out so far. Returns
+// NULL if the arena is full.
+void *nnx_arena_alloc(nnx_arena_t *arena, const uint32_t size, const uint32_t alignment);
+
+// Frees everything bump allocated after the mark was taken
+static inline uint32_t nnx_arena_mark(const nnx_arena_t *arena) {
+    return arena->top;
+}
+
+static inline void nnx_arena_release(nnx_arena_t *arena, const uint32_t mark) {
+    arena->top = mark;
+}
+
+#endif /* __PULP_NNX_ALLOC_H__ */
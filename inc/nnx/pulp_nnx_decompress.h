@@ -0,0 +1,44 @@
+/*
+ * pulp_nnx_decompress.h
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PULP_NNX_DECOMPRESS_H__
+#define __PULP_NNX_DECOMPRESS_H__
+
+#include "pulp_nnx_hal.h"
+
+// Packed weights with the all-zero bit planes removed. A group is an output
+// channel, or 16 channels if the weights are depthwise.
+typedef struct {
+    uint8_t *bitmap;      // One bit per bit plane, set if the plane is stored
+    uint32_t *offsets;    // Byte offset of every group's first stored plane, n_groups + 1 entries
+    uint8_t *literals;    // Stored bit planes in L2
+    int plane_size;       // Bytes per bit plane
+    int planes_per_group;
+    int n_groups;
+    int n_cores;          // Cores expanding the groups in parallel
+} nnx_compressed_weights_t;
+
+// Expands groups [g0, g0 + n) into dense packed weights at dst. The stored
+// planes of the groups are read from src, which starts with the first stored
+// plane of group g0. Returns once all the cores are done.
+void nnx_decompress_weights(const nnx_compressed_weights_t *weights,
+                            const uint8_t *src, uint8_t *dst,
+                            const int g0, const int n);
+
+#endif /* __PULP_NNX_DECOMPRESS_H__ */
@@ -122,6 +122,7 @@
 
 #define NE16_MASK_QUANT_FUNCTION (1 << 23)
 #define NE16_MASK_QUANT_MODE (3 << 21)
+#define NE16_MASK_FILTER_MODE (3 << 5)
 
 /* PADDING */
 
@@ -0,0 +1,64 @@
+/*
+ * pulp_nnx_epilogue.h
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PULP_NNX_EPILOGUE_H__
+#define __PULP_NNX_EPILOGUE_H__
+
+#include "pulp_nnx_hal.h"
+
+// Dense 8-bit HWC output tile and its origin in the output tensor
+typedef struct {
+    uint8_t *data;
+    int h0, w0, k0;
+    int height, width, depth;
+} nnx_tile_t;
+
+// Called on every core of the team, each core processes its share of rows
+typedef void (*nnx_epilogue_fn_t)(const nnx_tile_t *tile, void *arg);
+
+typedef struct {
+    nnx_epilogue_fn_t fn;  // NULL if there is no epilogue
+    void *arg;
+    int n_cores;
+} nnx_epilogue_t;
+
+typedef struct {
+    uint8_t low;
+    uint8_t high;
+} nnx_clip_args_t;
+
+typedef struct {
+    nnx_feature_t skip;    // Same shape as the output
+} nnx_add_args_t;
+
+typedef struct {
+    nnx_feature_t output;  // Pooled output, half the height and width
+} nnx_maxpool_args_t;
+
+// Runs the epilogue on the cluster cores and returns once all are done
+void nnx_run_epilogue(const nnx_epilogue_t *epilogue, const nnx_tile_t *tile);
+
+// In place clip of the tile to [low, high]
+void nnx_epilogue_clip(const nnx_tile_t *tile, void *arg);
+// In place saturating add of the matching slice of the skip tensor
+void nnx_epilogue_add(const nnx_tile_t *tile, void *arg);
+// 2x2 max pooling into the pooled output, the tile origin and size must be even
+void nnx_epilogue_maxpool2x2(const nnx_tile_t *tile, void *arg);
+
+#endif /* __PULP_NNX_EPILOGUE_H__ */
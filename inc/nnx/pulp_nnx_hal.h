@@ -35,35 +35,37 @@
 
 #define BIT_SET(var, bits) var |= bits
 
-#define NE16_WRITE(offset, value) \
-  *(int volatile *)(NE16_BASE_ADDR + (offset)) = (value)
-#define NE16_WRITE_BE(offset, value, be) \
-  *(char volatile *)(NE16_BASE_ADDR + (offset) + (be)) = (value)
-#define NE16_READ(offset) *(int volatile *)(NE16_BASE_ADDR + (offset))
-
-#define NE16_WRITE_IO_REG(offset, value) \
-  NE16_WRITE(NE16_REGISTER_OFFSET + (offset), (value))
-#define NE16_WRITE_IO_REG_BE(offset, value, be) \
-  NE16_WRITE_BE(NE16_REGISTER_OFFSET + (offset), (value), (be))
-#define NE16_READ_IO_REG(offset) NE16_READ(NE16_REGISTER_OFFSET + (offset))
-
-#define NE16_BARRIER_NOSTATUS()      eu_evt_maskWaitAndClr (1 << NE16_EVT0)
-#define NE16_BARRIER()               do { eu_evt_maskWaitAndClr (1 << NE16_EVT0); } while((*(int volatile *)(NE16_BASE_ADDR + NE16_STATUS)) != 0)
-#define NE16_BUSYWAIT()              do {                                         } while((*(int volatile *)(NE16_BASE_ADDR + NE16_STATUS)) != 0)
-#define NE16_BARRIER_ACQUIRE(job_id) job_id = NE16_READ(NE16_ACQUIRE); \
-                                     while(job_id < 0) { eu_evt_maskWaitAndClr (1 << NE16_EVT0); job_id = NE16_READ(NE16_ACQUIRE); };
-#define NE16_NOBARRIER_ACQUIRE(job_id) job_id = NE16_READ(NE16_ACQUIRE); \
-                                       while(job_id < 0) { job_id = NE16_READ(NE16_ACQUIRE); };
+#define NE16_WRITE(dev, offset, value) \
+  *(int volatile *)((dev)->base_addr + (offset)) = (value)
+#define NE16_WRITE_BE(dev, offset, value, be) \
+  *(char volatile *)((dev)->base_addr + (offset) + (be)) = (value)
+#define NE16_READ(dev, offset) *(int volatile *)((dev)->base_addr + (offset))
+
+#define NE16_WRITE_IO_REG(dev, offset, value) \
+  NE16_WRITE(dev, NE16_REGISTER_OFFSET + (offset), (value))
+#define NE16_WRITE_IO_REG_BE(dev, offset, value, be) \
+  NE16_WRITE_BE(dev, NE16_REGISTER_OFFSET + (offset), (value), (be))
+#define NE16_READ_IO_REG(dev, offset) NE16_READ(dev, NE16_REGISTER_OFFSET + (offset))
+
+#define NE16_BARRIER_NOSTATUS(dev)      eu_evt_maskWaitAndClr (1 << (dev)->event)
+#define NE16_BARRIER(dev)               do { eu_evt_maskWaitAndClr (1 << (dev)->event); } while(NE16_READ(dev, NE16_STATUS) != 0)
+#define NE16_BUSYWAIT(dev)              do {                                            } while(NE16_READ(dev, NE16_STATUS) != 0)
+#define NE16_BARRIER_ACQUIRE(dev, job_id) job_id = NE16_READ(dev, NE16_ACQUIRE); \
+                                          while(job_id < 0) { eu_evt_maskWaitAndClr (1 << (dev)->event); job_id = NE16_READ(dev, NE16_ACQUIRE); };
+#define NE16_NOBARRIER_ACQUIRE(dev, job_id) job_id = NE16_READ(dev, NE16_ACQUIRE); \
+                                            while(job_id < 0) { job_id = NE16_READ(dev, NE16_ACQUIRE); };
 
 /* CLUSTER */
-#define NE16_CG_ENABLE()  *(volatile int*) (CLUSTER_CTRL_ADDR_BASE + CLUSTER_CTRL_HWPE_OFFS) |=  CLUSTER_CTRL_HWPE_CG_EN_MASK
-#define NE16_CG_DISABLE() *(volatile int*) (CLUSTER_CTRL_ADDR_BASE + CLUSTER_CTRL_HWPE_OFFS) &= ~CLUSTER_CTRL_HWPE_CG_EN_MASK
+#define NE16_CLUSTER_CTRL(dev) *(volatile int*) ((dev)->cluster_ctrl + CLUSTER_CTRL_HWPE_OFFS)
 
-#define NE16_SETPRIORITY_CORE() *(volatile int*) (CLUSTER_CTRL_ADDR_BASE + CLUSTER_CTRL_HWPE_OFFS) &= ~CLUSTER_CTRL_HWPE_HCI_PRIO_MASK
-#define NE16_SETPRIORITY_NE16() *(volatile int*) (CLUSTER_CTRL_ADDR_BASE + CLUSTER_CTRL_HWPE_OFFS) |=  CLUSTER_CTRL_HWPE_HCI_PRIO_MASK
+#define NE16_CG_ENABLE(dev)  NE16_CLUSTER_CTRL(dev) |=  CLUSTER_CTRL_HWPE_CG_EN_MASK
+#define NE16_CG_DISABLE(dev) NE16_CLUSTER_CTRL(dev) &= ~CLUSTER_CTRL_HWPE_CG_EN_MASK
 
-#define NE16_RESET_MAXSTALL()  *(volatile int*) (CLUSTER_CTRL_ADDR_BASE + CLUSTER_CTRL_HWPE_OFFS) &= ~CLUSTER_CTRL_HWPE_HCI_MAXSTALL_MASK
-#define NE16_SET_MAXSTALL(val) *(volatile int*) (CLUSTER_CTRL_ADDR_BASE + CLUSTER_CTRL_HWPE_OFFS) |=  (val & CLUSTER_CTRL_HWPE_HCI_MAXSTALL_MASK)
+#define NE16_SETPRIORITY_CORE(dev) NE16_CLUSTER_CTRL(dev) &= ~CLUSTER_CTRL_HWPE_HCI_PRIO_MASK
+#define NE16_SETPRIORITY_NE16(dev) NE16_CLUSTER_CTRL(dev) |=  CLUSTER_CTRL_HWPE_HCI_PRIO_MASK
+
+#define NE16_RESET_MAXSTALL(dev)  NE16_CLUSTER_CTRL(dev) &= ~CLUSTER_CTRL_HWPE_HCI_MAXSTALL_MASK
+#define NE16_SET_MAXSTALL(dev, val) NE16_CLUSTER_CTRL(dev) |=  (val & CLUSTER_CTRL_HWPE_HCI_MAXSTALL_MASK)
 
 
 #define DIVNCEIL(A,B)  ( (((A) - 1) / (B)) + 1 )
@@ -97,14 +99,26 @@ typedef enum {
     featureBitwidth32Bit = 32
 } nnx_feature_bitwidth_e;
 
+// HWC tensor, or a view into a larger one. Views keep the strides of the
+// tensor they point into, a zero stride means the tensor is dense.
 typedef struct {
     void *data;
     uint16_t height;
     uint16_t width;
     uint16_t depth;
     nnx_feature_bitwidth_e bitwidth;
+    uint16_t row_stride;     // Pixels from one row to the next, 0 if equal to width
+    uint16_t channel_stride; // Channels from one pixel to the next, 0 if equal to depth
 } nnx_feature_t;
 
+static inline int nnx_row_stride(const nnx_feature_t *feature) {
+    return feature->row_stride != 0 ? feature->row_stride : feature->width;
+}
+
+static inline int nnx_channel_stride(const nnx_feature_t *feature) {
+    return feature->channel_stride != 0 ? feature->channel_stride : feature->depth;
+}
+
 typedef enum {
     normMode8Bit = NE16_NORM_MODE_8BIT,
     normMode16Bit = NE16_NORM_MODE_16BIT,
@@ -188,32 +202,107 @@ typedef struct {
     nnx_cfg_t cfg;
 } nnx_task_t;
 
-uint8_t nnx_job_id();
-int  nnx_empty();
-int  nnx_full();
-void nnx_soft_clear();
-int  nnx_acquire();
-void nnx_offload(nnx_task_t *task);
-void nnx_offload_ptr(nnx_task_t *task);
-void nnx_run_async();
-void nnx_run();
-void nnx_commit();
-void nnx_wait_empty();
-void nnx_wait_not_full();
-void nnx_wait_on_id(const uint8_t id);
-void nnx_busywait();
-void nnx_init();
-void nnx_term();
+// One NE16 instance. Jobs and configurations of different instances are
+// independent, so several of them can work on the same layer.
+typedef struct {
+    uint32_t base_addr;     // Register file of the NE16
+    uint32_t cluster_ctrl;  // Control unit of the cluster the NE16 sits in
+    int event;              // Event line raised on job completion
+    // Set by nnx_conv_* and used by the matching *_update_dims
+    int qw;
+    int weight_d0_stride;
+    int outbytes;
+    int stride_shift;
+} nnx_dev_t;
+
+// The NE16 of the cluster the code is running on
+#define NNX_DEV_DEFAULT                         \
+    {                                           \
+        .base_addr = NE16_BASE_ADDR,            \
+        .cluster_ctrl = CLUSTER_CTRL_ADDR_BASE, \
+        .event = NE16_EVT0                      \
+    }
 
+typedef enum {
+    priorityOwnerCore = 0,
+    priorityOwnerNe16 = 1
+} nnx_priority_owner_e;
+
+// Arbitration of the shared TCDM interconnect between the NE16 and the cores.
+// The side without priority is stalled for at most max_stall cycles.
+typedef struct {
+    nnx_priority_owner_e owner;
+    uint8_t max_stall;
+} nnx_arbitration_t;
+
+// Arbitration for the phases of a layer
+typedef struct {
+    nnx_arbitration_t exclusive;   // Only the NE16 is working
+    nnx_arbitration_t concurrent;  // The cores work next to the NE16, e.g. DMA management or post-ops
+} nnx_arbitration_policy_t;
+
+#define NNX_ARBITRATION_DEFAULT          \
+    {                                    \
+        .owner = priorityOwnerNe16,      \
+        .max_stall = 0                   \
+    }
+
+#define NNX_SESSION_NO_TIMEOUT (0)
+
+// Keeps the NE16 clocked and configured across many jobs. Time is measured in
+// whatever unit the caller passes to nnx_session_poll, e.g. cycles.
+typedef struct {
+    int clock_enabled;
+    int active;             // Used since the last poll
+    uint32_t idle_timeout;  // NNX_SESSION_NO_TIMEOUT never gates the clock
+    uint32_t last_active;
+} nnx_session_t;
+
+uint8_t nnx_job_id(nnx_dev_t *dev);
+int  nnx_empty(nnx_dev_t *dev);
+int  nnx_full(nnx_dev_t *dev);
+void nnx_soft_clear(nnx_dev_t *dev);
+int  nnx_acquire(nnx_dev_t *dev);
+void nnx_offload(nnx_dev_t *dev, nnx_task_t *task);
+void nnx_offload_ptr(nnx_dev_t *dev, nnx_task_t *task);
+void nnx_run_async(nnx_dev_t *dev);
+void nnx_run(nnx_dev_t *dev);
+void nnx_commit(nnx_dev_t *dev);
+void nnx_wait_empty(nnx_dev_t *dev);
+void nnx_wait_not_full(nnx_dev_t *dev);
+void nnx_wait_on_id(nnx_dev_t *dev, const uint8_t id);
+void nnx_busywait(nnx_dev_t *dev);
+void nnx_init(nnx_dev_t *dev);
+void nnx_term(nnx_dev_t *dev);
+void nnx_set_arbitration(nnx_dev_t *dev, const nnx_arbitration_t arbitration);
+void nnx_session_open(nnx_dev_t *dev, nnx_session_t *session, const uint32_t idle_timeout);
+void nnx_session_begin(nnx_dev_t *dev, nnx_session_t *session);
+void nnx_session_poll(nnx_dev_t *dev, nnx_session_t *session, const uint32_t now);
+void nnx_session_clear(nnx_dev_t *dev, nnx_session_t *session);
+void nnx_session_close(nnx_dev_t *dev, nnx_session_t *session);
+
+// Only touch the configuration, so they do not need a device
 void nnx_task_init(nnx_task_t *task);
 int nnx_pad_input(nnx_cfg_t *cfg, nnx_padding_t padding);
 int nnx_norm_quant(nnx_cfg_t *cfg, nnx_norm_t norm, nnx_quant_t quant);
 void nnx_mask_filter(nnx_cfg_t *cfg, uint8_t top, uint8_t right, uint8_t bottom, uint8_t left);
-nnx_error_code nnx_conv_1x1(nnx_cfg_t *cfg, nnx_weights_t weights, nnx_feature_t input, nnx_feature_t output, nnx_padding_t padding, const stride);
-nnx_error_code nnx_conv_1x1_update_dims(nnx_cfg_t *cfg, int h_out, int w_out, int w_in, int k_out, int k_in, int w_in_stride, int w_out_stride, nnx_padding_t padding);
-nnx_error_code nnx_conv_3x3(nnx_cfg_t *cfg, nnx_weights_t weights, nnx_feature_t input, nnx_feature_t output, nnx_padding_t padding, const stride);
-nnx_error_code nnx_conv_3x3_update_dims(nnx_cfg_t *cfg, int h_out, int w_out, int w_in, int k_out, int k_in, int w_in_stride, int w_out_stride, nnx_padding_t padding);
-nnx_error_code nnx_conv_3x3_dw(nnx_cfg_t *cfg, nnx_weights_t weights, nnx_feature_t input, nnx_feature_t output, nnx_padding_t padding, const stride);
-nnx_error_code nnx_conv_3x3_dw_update_dims(nnx_cfg_t *cfg, int h_out, int w_out, int w_in, int k_out, int k_in, int w_in_stride, int w_out_stride, nnx_padding_t padding);
+// With streamin the accumulators start from the tensor at the output pointer,
+// read with the output strides and bitwidth, instead of zero. The values are
+// added before normalization and quantization, and the output overwrites them.
+void nnx_streamin(nnx_cfg_t *cfg, int enable);
+
+// The input and output may be views into larger tensors, e.g. a channel slice
+// of the input or the channels of a concatenated output. The update_dims
+// functions take the strides of the views, w_*_stride in pixels per row and
+// k_*_stride in channels per pixel. The NE16 streamers need word aligned
+// addresses, so tensors must start word aligned and views must also keep a
+// pixel stride of a multiple of 4 bytes, otherwise dimensionMismatch is
+// returned.
+nnx_error_code nnx_conv_1x1(nnx_dev_t *dev, nnx_cfg_t *cfg, nnx_weights_t weights, nnx_feature_t input, nnx_feature_t output, nnx_padding_t padding, const stride);
+nnx_error_code nnx_conv_1x1_update_dims(nnx_dev_t *dev, nnx_cfg_t *cfg, int h_out, int w_out, int w_in, int k_out, int k_in, int w_in_stride, int w_out_stride, int k_in_stride, int k_out_stride, nnx_padding_t padding);
+nnx_error_code nnx_conv_3x3(nnx_dev_t *dev, nnx_cfg_t *cfg, nnx_weights_t weights, nnx_feature_t input, nnx_feature_t output, nnx_padding_t padding, const stride);
+nnx_error_code nnx_conv_3x3_update_dims(nnx_dev_t *dev, nnx_cfg_t *cfg, int h_out, int w_out, int w_in, int k_out, int k_in, int w_in_stride, int w_out_stride, int k_in_stride, int k_out_stride, nnx_padding_t padding);
+nnx_error_code nnx_conv_3x3_dw(nnx_dev_t *dev, nnx_cfg_t *cfg, nnx_weights_t weights, nnx_feature_t input, nnx_feature_t output, nnx_padding_t padding, const stride);
+nnx_error_code nnx_conv_3x3_dw_update_dims(nnx_dev_t *dev, nnx_cfg_t *cfg, int h_out, int w_out, int w_in, int k_out, int k_in, int w_in_stride, int w_out_stride, int k_in_stride, int k_out_stride, nnx_padding_t padding);
 
 #endif /* __NE16_H__ */
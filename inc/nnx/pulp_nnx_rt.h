@@ -0,0 +1,181 @@
+/*
+ * pulp_nnx_rt.h
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PULP_NNX_RT_H__
+#define __PULP_NNX_RT_H__
+
+#include "pulp_nnx_hal.h"
+#include "pulp_nnx_epilogue.h"
+#include "pulp_nnx_decompress.h"
+
+// Runs the same configured task over n_frames consecutive frames. The task
+// must be fully configured beforehand, only its infeat_ptr and outfeat_ptr
+// fields are updated for each frame.
+void nnx_run_batch(nnx_dev_t *dev, nnx_task_t *task,
+                   const uint32_t infeat_ptr, const uint32_t infeat_frame_size,
+                   const uint32_t outfeat_ptr, const uint32_t outfeat_frame_size,
+                   const int n_frames);
+
+typedef enum {
+    tileOrderSpatialOuter = 0, // Input tile stays, weights change every tile
+    tileOrderChannelOuter = 1  // Weights stay, input changes every tile
+} nnx_tile_order_e;
+
+typedef struct {
+    uint16_t height; // Output tile height
+    uint16_t width;  // Output tile width
+    uint16_t depth;  // Output tile channels
+    nnx_tile_order_e order;
+} nnx_tile_plan_t;
+
+typedef struct {
+    uint8_t *input;
+    uint8_t *weights;
+    uint8_t *scale;
+    uint8_t *output;
+    uint8_t *compressed; // Stored planes of the weight tile, only with compressed weights
+} nnx_tile_buffer_t;
+
+typedef struct {
+    uint32_t decompress_cycles; // Spent by the cores expanding weight tiles
+    int ne16_idle;              // Tiles the NE16 had to wait for
+} nnx_tiled_stats_t;
+
+typedef struct {
+    nnx_dev_t *dev;
+    nnx_task_t *task;       // Configured for the whole layer on dev
+    nnx_feature_t input;    // HWC tensor or view in L2
+    nnx_feature_t output;   // HWC tensor or view in L2, NULL data if only the epilogue consumes the tiles
+    nnx_weights_t weights;  // Packed weights in L2, ignored if compressed
+    const nnx_compressed_weights_t *compressed; // NULL if the weights are not compressed
+    void *scale;            // Normalization scale in L2
+    int scale_bytes;        // Bytes of the normalization scale per channel
+    nnx_tile_buffer_t buffer[NNX_CONTEXT_SIZE]; // L1 buffers, one set per context
+    nnx_epilogue_t epilogue; // Applied to every output tile before it is stored
+    const nnx_arbitration_policy_t *arbitration; // NULL keeps the current arbitration
+    nnx_tiled_stats_t stats; // Accumulated over runs, needs the cycle counter running
+} nnx_tiled_layer_t;
+
+// Splits an unpadded stride 1 layer into output tiles following the plan.
+// Tiles are moved between L2 and the L1 buffers with the cluster DMA and the
+// epilogue of a tile runs on the cores, both while the NE16 computes the next
+// tile. Compressed weights are expanded into L1 by the cores at the same
+// point.
+void nnx_run_tiled(nnx_tiled_layer_t *layer, const nnx_tile_plan_t plan);
+
+// Runs the part-th of n_parts contiguous shares of the layer's tiles, split
+// at tile boundaries in the order of the plan. Every tile belongs to exactly
+// one part, but a part may end in the middle of the channel tiles of a
+// spatial tile, or of the spatial tiles of a channel tile. Meant for
+// splitting a layer between the NE16s of several clusters, each running its
+// own part.
+void nnx_run_tiled_part(nnx_tiled_layer_t *layer, const nnx_tile_plan_t plan,
+                        const int part, const int n_parts);
+
+// Spreads the tiles of a layer over n_devices NE16s of the current cluster,
+// each one driven by its own core. Every layers[i] describes the same layer
+// with its own device, task and L1 buffers. The epilogue and the compressed
+// weights fork the cluster team, so they must be unset, and so must the
+// arbitration since all the devices share the cluster control unit.
+void nnx_run_tiled_multi(nnx_tiled_layer_t *layers, const int n_devices,
+                         const nnx_tile_plan_t plan);
+
+// Grouped convolution as a sequence of NE16 jobs. Every job convolves a
+// batch of consecutive groups, packed as one dense layer with block diagonal
+// weights, so that small groups still fill the NE16's 16 input channels.
+typedef struct {
+    nnx_dev_t *dev;
+    nnx_task_t *task;       // Configured for the first job, on channel views of the input and output
+    nnx_feature_t input;    // HWC tensor or view in L1
+    nnx_feature_t output;   // HWC tensor or view in L1
+    uint8_t *weights;       // Packed weights of every job, one after the other
+    int weights_job_size;   // Bytes of packed weights per job
+    uint8_t *scale;         // Normalization scale in L1
+    int scale_bytes;        // Bytes of the normalization scale per channel
+    int n_jobs;             // Jobs split the input and output channels evenly
+} nnx_grouped_conv_t;
+
+// Runs the jobs of a grouped convolution. Only the pointers differ between
+// jobs, so they are queued in both contexts and every context is programmed
+// in full only once. Returns dimensionMismatch if the input or output
+// channels do not split evenly into n_jobs.
+nnx_error_code nnx_run_grouped(nnx_grouped_conv_t *conv);
+
+// Unpadded stride 1 3x3 convolution with a dilated kernel
+typedef struct {
+    nnx_dev_t *dev;
+    nnx_task_t *task;       // Configured as a dense or depthwise 3x3 convolution
+    nnx_feature_t input;    // HWC tensor or view in L1
+    nnx_feature_t output;   // HWC tensor or view in L1, 2 * dilation smaller than the input
+    int dilation;
+} nnx_dilated_conv_t;
+
+// Outputs whose coordinates are equal modulo the dilation only read inputs
+// of the same phase, so the dilated convolution splits into dilation^2 dense
+// 3x3 jobs, one per phase. Every job reads and writes its phase in place
+// through dilated views of the input and output. Returns dimensionMismatch,
+// without running any job, if the input is not 2 * dilation larger than the
+// output or if a phase view is not word aligned, i.e. dilation pixels of the
+// tensors must span a multiple of 4 bytes.
+nnx_error_code nnx_run_dilated(nnx_dilated_conv_t *conv);
+
+// Fixed point factor multiplier / 2^shift
+typedef struct {
+    int32_t multiplier;
+    uint8_t shift;
+} nnx_rescale_t;
+
+#define NNX_RESCALE_IDENTITY { .multiplier = 1, .shift = 0 }
+
+// Convolution followed by the addition of a skip connection, both done by one
+// NE16 job that streams the skip tensor into its accumulators
+typedef struct {
+    nnx_dev_t *dev;
+    nnx_task_t *task;       // Configured for the convolution, with streamin enabled
+    nnx_feature_t input;    // HWC tensor or view in L1
+    nnx_feature_t skip;     // 8-bit tensor or view in L1, same shape as the output
+    nnx_feature_t output;   // 8-bit tensor or view in L1, may share the data of the skip
+    nnx_rescale_t skip_rescale; // From the skip's quantization step to the accumulators'
+    int n_cores;            // Cores staging the skip tensor
+} nnx_residual_conv_t;
+
+// The NE16 streams in through the output pointer, strides and bitwidth, so
+// the skip tensor must be in the output buffer, as 8-bit values in the step
+// of the accumulators, before the job. A skip that already is the output and
+// needs no rescaling goes straight to the NE16. Otherwise the cores first
+// write the rescaled skip into the output, saturated to 8 bits. The
+// accumulator step is usually 2^shift / scale times finer than the output
+// step, so a skip in the output step keeps about 8 - shift bits.
+void nnx_run_residual(nnx_residual_conv_t *conv);
+
+typedef struct {
+    nnx_dev_t *dev;
+    nnx_task_t *dw_task;   // Depthwise 3x3 job, configured for the whole layer
+    nnx_task_t *pw_task;   // Pointwise 1x1 job, configured for the whole layer
+    nnx_feature_t input;   // HWC tensor or view in L1
+    nnx_feature_t output;  // HWC tensor or view in L1
+    uint8_t *scratch;      // L1 buffer holding one intermediate tile
+} nnx_fused_block_t;
+
+// Runs a depthwise 3x3 and a pointwise 1x1 convolution tile by tile. The
+// intermediate tile never leaves the scratch buffer. Only the plan's height
+// and width are used, the channels are never split.
+void nnx_run_fused_dw_pw(nnx_fused_block_t *block, const nnx_tile_plan_t plan);
+
+#endif /* __PULP_NNX_RT_H__ */
@@ -0,0 +1,117 @@
+/*
+ * pulp_nnx_trace.h
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PULP_NNX_TRACE_H__
+#define __PULP_NNX_TRACE_H__
+
+#include <stdint.h>
+#include "pmsis.h"
+
+// Compile with -DNNX_TRACE=1 to record the events, otherwise the
+// instrumentation compiles to nothing.
+#ifndef NNX_TRACE
+#define NNX_TRACE 0
+#endif
+
+// Entries per core, must be a power of two. Older entries are overwritten.
+#ifndef NNX_TRACE_SIZE
+#define NNX_TRACE_SIZE 128
+#endif
+
+_Static_assert((NNX_TRACE_SIZE & (NNX_TRACE_SIZE - 1)) == 0, "NNX_TRACE_SIZE must be a power of two");
+
+#ifndef NNX_TRACE_MEMORY
+#define NNX_TRACE_MEMORY PI_L1
+#endif
+
+#ifndef NNX_TRACE_CORES
+#ifdef NUM_CORES
+#define NNX_TRACE_CORES NUM_CORES
+#else
+#define NNX_TRACE_CORES 8
+#endif
+#endif
+
+// All cores read the cluster timer, so their timestamps share one time base.
+// The per-core cycle counters are not used since they are started, and reset
+// between measurements, by the master core only. nnx_trace_reset() restarts
+// the timer, which counts cluster clock cycles.
+#ifndef NNX_TRACE_TIMER
+#define NNX_TRACE_TIMER timer_base_cl(0, 0, 0)
+#endif
+
+#ifndef NNX_TRACE_CLOCK
+#define NNX_TRACE_CLOCK() timer_count_get(NNX_TRACE_TIMER)
+#endif
+
+// Must match EVENTS in trace_decode.py
+typedef enum {
+    traceEventAcquire = 0,      // arg: job id
+    traceEventOffload = 1,
+    traceEventTrigger = 2,
+    traceEventCompletion = 3,   // arg: 1 if other jobs may still be running
+    traceEventDmaStart = 4,     // arg: bytes
+    traceEventDmaFinish = 5,
+    traceEventEpilogueStart = 6,    // arg: bytes
+    traceEventEpilogueFinish = 7,
+    traceEventDecompressStart = 8,  // arg: groups
+    traceEventDecompressFinish = 9
+} nnx_trace_event_e;
+
+typedef struct {
+    uint32_t timestamp;
+    uint16_t event;
+    uint16_t arg;
+} nnx_trace_entry_t;
+
+// Every core records into its own ring, so no synchronization is needed
+typedef struct {
+    nnx_trace_entry_t entries[NNX_TRACE_SIZE];
+    uint32_t head;  // Number of events recorded so far
+} nnx_trace_ring_t;
+
+#if NNX_TRACE
+
+extern NNX_TRACE_MEMORY nnx_trace_ring_t nnx_trace_rings[NNX_TRACE_CORES];
+
+static inline void nnx_trace_record(const nnx_trace_event_e event, const uint32_t arg) {
+    nnx_trace_ring_t *ring = &nnx_trace_rings[pi_core_id()];
+    nnx_trace_entry_t *entry = &ring->entries[ring->head & (NNX_TRACE_SIZE - 1)];
+    entry->timestamp = NNX_TRACE_CLOCK();
+    entry->event = event;
+    entry->arg = arg > 0xffff ? 0xffff : arg;
+    ring->head++;
+}
+
+#define NNX_TRACE_EVENT(event, arg) nnx_trace_record((event), (arg))
+
+#else
+
+#define NNX_TRACE_EVENT(event, arg) do { } while (0)
+
+#endif  // NNX_TRACE
+
+// Clears the rings of all cores and restarts the cluster timer
+void nnx_trace_reset();
+
+// Prints the recorded events, oldest first, in the format read by
+// trace_decode.py. Does nothing if tracing is compiled out.
+void nnx_trace_dump();
+
+#endif /* __PULP_NNX_TRACE_H__ */
@@ -0,0 +1,89 @@
+/*
+ * pulp_nnx_view.h
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PULP_NNX_VIEW_H__
+#define __PULP_NNX_VIEW_H__
+
+#include "pulp_nnx_hal.h"
+
+// Views describe part of a tensor in place, so layers can read a slice of
+// their input or write into their slot of a larger output without copies.
+
+// The (height x width x depth) block of the tensor starting at (h0, w0, k0)
+static inline nnx_feature_t nnx_view(const nnx_feature_t *tensor,
+                                     const int h0, const int w0, const int k0,
+                                     const int height, const int width, const int depth) {
+    const int row_stride = nnx_row_stride(tensor);
+    const int channel_stride = nnx_channel_stride(tensor);
+    const int offset = ((h0 * row_stride + w0) * channel_stride + k0) * tensor->bitwidth / 8;
+
+    const nnx_feature_t view = {
+        .data = (uint8_t *)tensor->data + offset,
+        .height = height,
+        .width = width,
+        .depth = depth,
+        .bitwidth = tensor->bitwidth,
+        .row_stride = row_stride,
+        .channel_stride = channel_stride
+    };
+    return view;
+}
+
+// Channels [k0, k0 + depth) of the tensor, e.g. the slot of one branch in a
+// channel concatenation or one part of a channel split
+static inline nnx_feature_t nnx_view_channels(const nnx_feature_t *tensor, const int k0, const int depth) {
+    return nnx_view(tensor, 0, 0, k0, tensor->height, tensor->width, depth);
+}
+
+// Rows [h0, h0 + height) of the tensor
+static inline nnx_feature_t nnx_view_rows(const nnx_feature_t *tensor, const int h0, const int height) {
+    return nnx_view(tensor, h0, 0, 0, height, tensor->width, tensor->depth);
+}
+
+// Every dilation-th pixel of the tensor in both directions, starting at
+// (h0, w0). A view pixel spans dilation pixels of the tensor. Rows are
+// row_stride pixels apart, so the grown pixel stride also skips dilation
+// rows of the tensor.
+static inline nnx_feature_t nnx_view_dilated(const nnx_feature_t *tensor,
+                                             const int h0, const int w0, const int dilation,
+                                             const int height, const int width) {
+    nnx_feature_t view = nnx_view(tensor, h0, w0, 0, height, width, tensor->depth);
+    view.channel_stride *= dilation;
+    return view;
+}
+
+// Views cannot overlap themselves and the streamers need them word aligned.
+// Dense tensors may have pixels of any size.
+static inline int nnx_view_fits(const nnx_feature_t *feature) {
+    const int channel_stride = nnx_channel_stride(feature);
+
+    if (channel_stride < feature->depth || nnx_row_stride(feature) < feature->width)
+        return 0;
+
+    if (((uint32_t)feature->data & 3) != 0)
+        return 0;
+
+    return channel_stride == feature->depth || (channel_stride * feature->bitwidth / 8) % 4 == 0;
+}
+
+static inline int nnx_is_dense(const nnx_feature_t *feature) {
+    return nnx_row_stride(feature) == feature->width && nnx_channel_stride(feature) == feature->depth;
+}
+
+#endif /* __PULP_NNX_VIEW_H__ */
@@ -15,10 +15,17 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 import os
+import math
 import argparse
 import torch
 import torch.nn.functional as F
 from Ne16 import *
+from autotune import autotune
+from arena import NE16_STREAM_ALIGNMENT, report as arena_report
+from cache import CACHE_MAX_BYTES, ContentCache, code_digest, data_bytes, write_if_changed
+
+# Packed weights and rendered vectors of previous runs
+cache = ContentCache()
 
 def license(filename):
     return \
@@ -72,10 +79,12 @@ def vector_size(data):
     else:
         return len(data)
 
-def vector_declaration(name, size):
+def vector_declaration(name, size, memory='PI_L1', align=None):
     retval = ""
     retval += define(f'{name}_size', size)
-    retval += f"PI_L1 uint8_t {name}[{name.upper()}_SIZE]"
+    retval += f"{memory} uint8_t {name}[{name.upper()}_SIZE]"
+    if align is not None:
+        retval += f" __attribute__((aligned({align})))"
     return retval
 
 def vector_initial_value(data, elements_per_row=10, spaces=4):
@@ -99,14 +108,24 @@ def vector_initial_value(data, elements_per_row=10, spaces=4):
 def vector_end():
     return ';\n\n'
 
-def render_vector(name, init=None, size=None, elements_per_row=10, spaces=4):
+def render_vector(name, init=None, size=None, elements_per_row=10, spaces=4, memory='PI_L1', align=None):
     size_ = vector_size(init) if init is not None else size
-    retval = ""
-    retval += vector_declaration(name, size_)
-    if init is not None:
-        retval += vector_initial_value(init, elements_per_row, spaces)
-    retval += vector_end()
-    return retval
+
+    def render():
+        retval = ""
+        retval += vector_declaration(name, size_, memory, align)
+        if init is not None:
+            retval += vector_initial_value(init, elements_per_row, spaces)
+        retval += vector_end()
+        return retval
+
+    # Only the initial values are worth caching
+    if init is None:
+        return render()
+
+    key = cache.key(code_digest(define, vector_declaration, vector_initial_value, vector_end),
+                    name, size_, elements_per_row, spaces, memory, align, data_bytes(init))
+    return cache.text('vectors', key, render)
 
 def check(name):
     return \
@@ -133,27 +152,42 @@ def generate_header(name, path, body):
     filename = name + '.h'
     filepath = os.path.join('inc', path, filename)
 
-    print(f'Generating header file -> {filepath}')
-
     filerender = license(filename)              \
                  + header_guard_begin(filename) \
                  + body                         \
                  + header_guard_end(filename)
 
-    with open(filepath, 'w') as file:
-        file.write(filerender)
+    # Unchanged headers keep their timestamp, so make only rebuilds the
+    # objects whose data changed
+    if write_if_changed(filepath, filerender):
+        print(f'Generating header file -> {filepath}')
+    else:
+        print(f'Unchanged header file  -> {filepath}')
 
-def generate_vector_header(name, data, golden=None):
+def generate_vector_header(name, data, golden=None, memory='PI_L1', size=None):
     bodyrender = ""
     bodyrender += includes()
-    bodyrender += render_vector(name, init=data, size=vector_size(golden) if golden is not None else None)
+    # Every tensor is read or written by the NE16 streamers or the DMA
+    bodyrender += render_vector(name, init=data, size=vector_size(golden) if golden is not None else size, memory=memory,
+                                align=NE16_STREAM_ALIGNMENT)
 
     if golden is not None:
-        bodyrender += render_vector('golden_' + name, init=golden)
+        bodyrender += render_vector('golden_' + name, init=golden, memory=memory)
         bodyrender += check(name)
         
     generate_header(name, 'data', bodyrender)
 
+def generate_compressed_weights_header(bitmap, offsets, literals, memory='PI_L1'):
+    # The bitmap and the offsets are read by the cores for every tile, so they
+    # always live in L1. The literals are moved by the DMA.
+    bodyrender = ""
+    bodyrender += includes()
+    bodyrender += render_vector("weights_bitmap", init=bitmap)
+    bodyrender += render_vector("weights_offsets", init=offsets.astype('<u4').tobytes(), align=4)
+    bodyrender += render_vector("weights_literals", init=literals, memory=memory)
+
+    generate_header("weights", 'data', bodyrender)
+
 def render_dims(name, dims):
     retval = ""
     for dim_name, dim_value in zip(dims["names"], dims["shape"]):
@@ -178,6 +212,27 @@ def generate_dims_header(name, info):
 
     generate_header(name, 'data', bodyrender)
 
+def generate_tile_plan_header(plan):
+    bodyrender = ""
+    bodyrender += includes()
+    for name in ['height', 'width', 'depth', 'order']:
+        bodyrender += define(f'tile_{name}', plan[name])
+    bodyrender += define('tile_model_cycles', plan['cycles'])
+    bodyrender += define('tile_l1_footprint', plan['footprint'])
+    bodyrender += define('tile_l1_unplanned', plan['arena']['unplanned'])
+    bodyrender += '\n'
+
+    # One set of buffers per NE16 context, all of them in one arena where
+    # buffers that are never live at the same time share memory
+    arena = plan['arena']
+    for buffer, offset in sorted(arena['offsets'].items(), key=lambda item: (item[1], item[0])):
+        bodyrender += define(f'tile_{buffer}_offset', offset)
+        bodyrender += define(f'tile_{buffer}_size', arena['sizes'][buffer])
+    bodyrender += '\n'
+    bodyrender += render_vector('tile_arena', size=arena['size'], align=NE16_STREAM_ALIGNMENT)
+
+    generate_header('tile_plan', 'data', bodyrender)
+
 def borders(bits, signed = False):
     low = -(2 ** (bits-1)) if signed else 0
     high = 2 ** (bits-1) - 1 if signed else 2 ** bits - 1
@@ -189,43 +244,256 @@ def clip(x, bits, signed=False):
     x[x < low] = low
     return x
 
-def create_input(channels, spatial_dim):
-    size = (1, channels, spatial_dim, spatial_dim)
-    return torch.randint(low=0, high=100, size=size, dtype=torch.int32)
+def create_input(channels, spatial_dim, batch=1, high=100):
+    size = (batch, channels, spatial_dim, spatial_dim)
+    return torch.randint(low=0, high=high, size=size, dtype=torch.int32)
 
-def create_weights(shape):
+def create_weights(shape, high=5):
     """ Create weights
 
     Shape is of layout (Cout, H, W, Cin)
     """
     size = (shape[0], shape[3], shape[1], shape[2])  # Torch expects layout (Cout, Cin, H, W)
-    return torch.randint(low=0, high=5, size=size, dtype=torch.int32)
+    return torch.randint(low=0, high=high, size=size, dtype=torch.int32)
+
+def create_norm_scale(channels):
+    return np.ones((1, channels, 1, 1), dtype='<i4')
+
+def requantize(y, norm_scale, outshift):
+    y = torch.from_numpy(norm_scale) * y
+    return clip(y >> outshift, 8)
+
+# Must match the EPILOGUE_* values in layer_util.h
+EPILOGUES = ['none', 'clip', 'add', 'maxpool']
+EPILOGUE_CLIP_LOW = 16
+EPILOGUE_CLIP_HIGH = 200
+
+def apply_epilogue(y, epilogue, memory):
+    if epilogue == 'clip':
+        return torch.clamp(y, EPILOGUE_CLIP_LOW, EPILOGUE_CLIP_HIGH)
+    elif epilogue == 'add':
+        skip = torch.randint(low=0, high=100, size=y.shape, dtype=torch.int32)
+        generate_vector_header("skip", skip.permute(0, 2, 3, 1), memory=memory)
+        return clip(y + skip, 8)
+    elif epilogue == 'maxpool':
+        # The full resolution output only feeds the pooling
+        generate_vector_header("conv_output", None, memory=memory, size=vector_size(y))
+        return F.max_pool2d(y.type(torch.float), 2).type(torch.int32)
+    return y
+
+# Residual layers draw narrow inputs and weights so that their accumulators
+# stay close to the output step, see residual_scales
+RESIDUAL_INPUT_HIGH = 16
+RESIDUAL_WEIGHTS_HIGH = 3
+RESIDUAL_MIN_SKIP_BITS = 4
+
+def rescale_skip(skip, multiplier, shift):
+    """ Skip tensor in the quantization step of the accumulators
+
+    Matches the staging done by nnx_run_residual: rounded fixed point
+    multiplication saturated to 8 bits.
+    """
+    rounding = 1 << (shift - 1) if shift > 0 else 0
+    return clip((skip * multiplier + rounding) >> shift, 8)
+
+def residual_scales(acc, skip_step):
+    """ Output shift, skip rescaling and skip range of a residual layer
+
+    The NE16 streams in at the output bitwidth, so the skip enters the
+    accumulators as an unsigned 8-bit value in their quantization step. A skip
+    whose step is skip_step = (multiplier, shift) output steps is therefore
+    rescaled by multiplier * 2^outshift / 2^shift first. The output shift is
+    the smallest one that keeps every accumulator within the 8-bit output,
+    which leaves the most room for the rescaled skip. The skip is drawn from
+    the values that the rescaling does not saturate.
+    """
+    max_acc = int(acc.max())
+    outshift = max(0, math.ceil(math.log2((max_acc + 1) / 256)))
+
+    multiplier, shift = skip_step
+    multiplier <<= outshift
+    rounding = 1 << (shift - 1) if shift > 0 else 0
+    skip_high = min(256, ((256 << shift) - rounding - 1) // multiplier + 1)
 
-def create_layer(cin, cout, spatial_dim, kernel_shape, outshift=8):
-    x = create_input(cin, spatial_dim + kernel_shape - 1)
+    assert skip_high >= 2 ** RESIDUAL_MIN_SKIP_BITS, \
+        f"Accumulators up to {max_acc} need an output shift of {outshift}, which leaves the 8-bit streamin " \
+        f"room for skips below {skip_high} only. Use fewer input channels or a smaller kernel."
+    return outshift, (multiplier, shift), skip_high
+
+def block_diagonal_weights(w, groups, groups_per_job):
+    """ Dense weights of every job of a grouped convolution
+
+    w has the torch layout (Cout, Cin / groups, H, W). A job convolves
+    groups_per_job consecutive groups, so its weights connect every group only
+    to its own input channels.
+    """
+    ko, ki = w.shape[0] // groups, w.shape[1]
+    n = groups_per_job
+    jobs = []
+    for j in range(groups // n):
+        w_job = torch.zeros((n * ko, n * ki) + tuple(w.shape[2:]), dtype=w.dtype)
+        for g in range(n):
+            w_job[g * ko:(g + 1) * ko, g * ki:(g + 1) * ki] = w[(j * n + g) * ko:(j * n + g + 1) * ko]
+        jobs.append(w_job)
+    return jobs
+
+def create_layer(cin, cout, spatial_dim, kernel_shape, outshift=8, batch=1, l1_budget=None, epilogue='none',
+                 compress_weights=False, groups=1, dilation=1, residual=False, skip_step=(1, 0)):
+    tiled = l1_budget is not None
+    ne16 = Ne16()
+
+    # Tiled layers keep their tensors in L2 and move tiles into L1
+    memory = 'PI_L2' if tiled else 'PI_L1'
+
+    if epilogue != 'none':
+        assert tiled and batch == 1, "Epilogues run per tile, they need an L1 budget and a single frame"
+        assert epilogue != 'maxpool' or spatial_dim % 2 == 0, "Max pooling needs an even output size"
+
+    assert tiled or not compress_weights, "Weights are decompressed per tile, they need an L1 budget"
+
+    assert cin % groups == 0 and cout % groups == 0, "Groups must split the input and output channels evenly"
+    assert groups == 1 or not tiled, "Grouped layers run from L1, they cannot be tiled"
+    groups_per_job = ne16.groups_per_job(cin // groups, groups)
+    n_jobs = groups // groups_per_job
+    job_cin, job_cout = cin // n_jobs, cout // n_jobs
+    # Jobs address their channels through views, which must be word aligned
+    assert job_cin % 4 == 0 and job_cout % 4 == 0, \
+        f"Jobs of {job_cin} input and {job_cout} output channels are not word aligned"
+
+    if dilation > 1:
+        assert kernel_shape == 3 and groups == 1 and not tiled, "Dilation is supported by untiled dense 3x3 layers"
+        # Phases start at every pixel and step by dilation pixels
+        assert cin % 4 == 0 and cout % 4 == 0, "Dilated views need word aligned pixels"
+
+    if residual:
+        assert not tiled and groups == 1 and dilation == 1, "Residual layers run as a single untiled dense job"
+
+    if tiled:
+        layer = {'h': spatial_dim, 'w': spatial_dim, 'cin': cin, 'cout': cout, 'ks': kernel_shape, 'qw': 8, 'dw': False,
+                 'align': 2 if epilogue == 'maxpool' else 1}
+        if compress_weights:
+            layer['compressed'] = True
+        plan = autotune(layer, l1_budget)
+        arena_report('Tile', plan['arena'])
+        generate_tile_plan_header(plan)
+
+    x = create_input(cin, spatial_dim + dilation * (kernel_shape - 1), batch,
+                     high=RESIDUAL_INPUT_HIGH if residual else 100)
     x_save = x.permute(0, 2, 3, 1).type(torch.int32)
-    generate_vector_header("input", x_save)
+    generate_vector_header("input", x_save, memory=memory)
 
-    w = create_weights((cout, kernel_shape, kernel_shape, cin))
-    w_save = Ne16().conv_unroll(w.numpy(), 8, layout="CoutCinK", dw=False)
-    generate_vector_header("weights", w_save)
+    w = create_weights((cout, kernel_shape, kernel_shape, cin // groups), high=RESIDUAL_WEIGHTS_HIGH if residual else 5)
+    w_save = np.concatenate([cache.packed_weights(ne16, w_job.numpy(), 8, layout="CoutCinK", dw=False)
+                             for w_job in block_diagonal_weights(w, groups, groups_per_job)])
+    ks = (kernel_shape, kernel_shape)
 
-    #norm_scale = torch.ones((1, channels, 1, 1), dtype=torch.int32)
-    norm_scale = np.ones((1, cout, 1, 1), dtype='<i4')
-    generate_vector_header("normalization_scale", norm_scale.tobytes())
-    
-    y = F.conv2d(x, w).type(torch.int32)
-    y = torch.from_numpy(norm_scale) * y
-    y = clip(y >> outshift, 8)
+    if groups > 1:
+        print(f'{groups} groups of {cin // groups} input channels run as {n_jobs} jobs of {groups_per_job} groups')
+
+    if compress_weights:
+        bitmap, offsets, literals = ne16.compress_weights(w_save, cout, cin, ks, 8)
+        assert np.array_equal(ne16.decompress_weights(bitmap, literals, cout, cin, ks, 8), w_save)
+        generate_compressed_weights_header(bitmap, offsets, literals, memory=memory)
+
+        compressed_size = bitmap.size + offsets.size * 4 + literals.size
+        print(f'Weights compressed from {w_save.size} to {compressed_size} bytes, ratio {w_save.size / compressed_size:.2f}')
+    else:
+        generate_vector_header("weights", w_save, memory=memory)
+
+    norm_scale = create_norm_scale(cout)
+    generate_vector_header("normalization_scale", norm_scale.tobytes(), memory=memory)
+
+    y = F.conv2d(x, w, groups=groups, dilation=dilation).type(torch.int32)
+
+    skip_save = None
+    skip_rescale = (1, 0)
+    if residual:
+        outshift, skip_rescale, skip_high = residual_scales(y, skip_step)
+        print(f'Residual skip in [0, {skip_high}) rescaled by {skip_rescale[0]} / 2^{skip_rescale[1]}, output shift {outshift}')
+
+        # The skip tensor is streamed in from the output buffer, which the
+        # residual then overwrites
+        skip = create_input(cout, spatial_dim, batch, high=skip_high)
+        skip_save = skip.permute(0, 2, 3, 1).type(torch.int32)
+        y = y + rescale_skip(skip, *skip_rescale)
+
+    y = requantize(y, norm_scale, outshift)
     y_save = y.permute(0, 2, 3, 1).type(torch.int32)
-    generate_vector_header("output", None, golden=y_save)
+
+    y_epilogue = apply_epilogue(y, epilogue, memory)
+    y_epilogue_save = y_epilogue.permute(0, 2, 3, 1).type(torch.int32)
+    generate_vector_header("output", skip_save, golden=y_epilogue_save, memory=memory)
 
     generate_dims_header('dims',
                          [
                              {"type":"dims", "name": "input",    "data": {"shape": x_save.shape[1:], "names": ["height", "width", "channel"]}},
                              {"type":"dims", "name": "output",   "data": {"shape": y_save.shape[1:], "names": ["height", "width", "channel"]}},
                              {"type":"dims", "name": "weights",  "data": {"shape": w.shape,          "names": ["channel_out", "channel_in", "kernel_height", "kernel_width"]}},
-                             {"type":"def",  "name": "outshift", "data": outshift}
+                             {"type":"def",  "name": "outshift", "data": outshift},
+                             {"type":"def",  "name": "batch",    "data": batch},
+                             {"type":"def",  "name": "tiled",    "data": int(tiled)},
+                             {"type":"def",  "name": "fused_dw_pw", "data": 0},
+                             {"type":"def",  "name": "epilogue", "data": EPILOGUES.index(epilogue)},
+                             {"type":"dims", "name": "epilogue_output", "data": {"shape": y_epilogue_save.shape[1:], "names": ["height", "width", "channel"]}},
+                             {"type":"def",  "name": "epilogue_clip_low", "data": EPILOGUE_CLIP_LOW},
+                             {"type":"def",  "name": "epilogue_clip_high", "data": EPILOGUE_CLIP_HIGH},
+                             {"type":"def",  "name": "compressed_weights", "data": int(compress_weights)},
+                             {"type":"def",  "name": "weights_raw_size", "data": int(w_save.size)},
+                             {"type":"def",  "name": "weights_plane_size", "data": ne16.weights_plane_size(ks)},
+                             {"type":"def",  "name": "weights_planes_per_group", "data": ne16.weights_planes_per_group(cin, 8, False)},
+                             {"type":"def",  "name": "groups", "data": groups},
+                             {"type":"def",  "name": "dilation", "data": dilation},
+                             {"type":"def",  "name": "residual", "data": int(residual)},
+                             {"type":"def",  "name": "skip_multiplier", "data": skip_rescale[0]},
+                             {"type":"def",  "name": "skip_shift", "data": skip_rescale[1]},
+                             {"type":"def",  "name": "groups_per_job", "data": groups_per_job},
+                             {"type":"def",  "name": "weights_job_size", "data": ne16.weights_size(job_cout, job_cin, ks, 8, False)}
+                         ])
+
+def create_fused_block(cin, cout, spatial_dim, tile, outshift_dw=4, outshift_pw=8, batch=1):
+    """ Depthwise 3x3 followed by a pointwise 1x1 convolution (MobileNet block) """
+    x = create_input(cin, spatial_dim + 2, batch)
+    x_save = x.permute(0, 2, 3, 1).type(torch.int32)
+    generate_vector_header("input", x_save)
+
+    w_dw = create_weights((cin, 3, 3, 1))
+    w_dw_save = cache.packed_weights(Ne16(), w_dw.numpy(), 8, layout="CoutCinK", dw=True)
+    generate_vector_header("weights", w_dw_save)
+
+    w_pw = create_weights((cout, 1, 1, cin))
+    w_pw_save = cache.packed_weights(Ne16(), w_pw.numpy(), 8, layout="CoutCinK", dw=False)
+    generate_vector_header("weights_pw", w_pw_save)
+
+    norm_scale_dw = create_norm_scale(cin)
+    generate_vector_header("normalization_scale", norm_scale_dw.tobytes())
+
+    norm_scale_pw = create_norm_scale(cout)
+    generate_vector_header("normalization_scale_pw", norm_scale_pw.tobytes())
+
+    y = F.conv2d(x, w_dw, groups=cin).type(torch.int32)
+    y = requantize(y, norm_scale_dw, outshift_dw)
+    y = F.conv2d(y, w_pw).type(torch.int32)
+    y = requantize(y, norm_scale_pw, outshift_pw)
+    y_save = y.permute(0, 2, 3, 1).type(torch.int32)
+    generate_vector_header("output", None, golden=y_save)
+
+    generate_dims_header('dims',
+                         [
+                             {"type":"dims", "name": "input",       "data": {"shape": x_save.shape[1:], "names": ["height", "width", "channel"]}},
+                             {"type":"dims", "name": "output",      "data": {"shape": y_save.shape[1:], "names": ["height", "width", "channel"]}},
+                             {"type":"dims", "name": "weights",     "data": {"shape": w_dw.shape,       "names": ["channel_out", "channel_in", "kernel_height", "kernel_width"]}},
+                             {"type":"dims", "name": "weights_pw",  "data": {"shape": w_pw.shape,       "names": ["channel_out", "channel_in", "kernel_height", "kernel_width"]}},
+                             {"type":"def",  "name": "outshift",    "data": outshift_dw},
+                             {"type":"def",  "name": "outshift_pw", "data": outshift_pw},
+                             {"type":"def",  "name": "batch",       "data": batch},
+                             {"type":"def",  "name": "tiled",       "data": 0},
+                             {"type":"def",  "name": "fused_dw_pw", "data": 1},
+                             {"type":"def",  "name": "epilogue",    "data": 0},
+                             {"type":"def",  "name": "compressed_weights", "data": 0},
+                             {"type":"def",  "name": "groups",      "data": 1},
+                             {"type":"def",  "name": "dilation",    "data": 1},
+                             {"type":"def",  "name": "residual",    "data": 0},
+                             {"type":"def",  "name": "fused_tile",  "data": tile}
                          ])
 
 if __name__ == '__main__':
@@ -238,9 +506,49 @@ if __name__ == '__main__':
                         help='Number of output channels. Default: 32')
     parser.add_argument('--output-spatial-dimensions', '-osd', dest='spatial_dimensions', type=int, default=3,
                         help='Output spatial dimension. Default 3')
+    parser.add_argument('--batch', '-b', dest='batch', type=int, default=1,
+                        help='Number of input frames processed with the same layer configuration. Default: 1')
+    parser.add_argument('--l1-budget', dest='l1_budget', type=int, default=None,
+                        help='L1 memory budget in bytes. If set, the layer is tiled with the autotuned tile plan. Default: untiled')
+    parser.add_argument('--fused-dw-pw', dest='fused_dw_pw', action='store_true',
+                        help='Generate a fused depthwise 3x3 + pointwise 1x1 block instead of a single layer.')
+    parser.add_argument('--fused-tile', dest='fused_tile', type=int, default=6,
+                        help='Spatial size of the fused block tile, kept in L1 between the two jobs. Default: 6')
+    parser.add_argument('--epilogue', dest='epilogue', choices=EPILOGUES, default='none',
+                        help='Post-op run on the cluster cores for every output tile of a tiled layer. Default: none')
+    parser.add_argument('--compress-weights', dest='compress_weights', action='store_true',
+                        help='Store the weights without their all-zero bit planes and expand every weight tile on the cluster cores. Needs an L1 budget.')
+    parser.add_argument('--groups', '-g', dest='groups', type=int, default=1,
+                        help='Number of groups of a grouped convolution. Small groups are batched into one NE16 job. Default: 1')
+    parser.add_argument('--dilation', '-d', dest='dilation', type=int, default=1,
+                        help='Dilation of a 3x3 kernel, run as one dense job per phase of the input. Default: 1')
+    parser.add_argument('--residual', dest='residual', action='store_true',
+                        help='Add a skip tensor to the accumulators before requantization, streamed in by the NE16 within the same job.')
+    parser.add_argument('--skip-step', dest='skip_step', type=int, nargs=2, default=[1, 0], metavar=('MULTIPLIER', 'SHIFT'),
+                        help='Quantization step of the residual skip tensor in output steps, multiplier / 2^shift. Default: 1 0')
+    parser.add_argument('--seed', dest='seed', type=int, default=None,
+                        help='Seed of the random tensors. Runs with the same seed and shapes reuse the cached packed weights and headers. Default: random')
+    parser.add_argument('--no-cache', dest='cache', action='store_false',
+                        help='Pack and render everything from scratch without touching the cache in .cache/.')
+    parser.add_argument('--cache-size', dest='cache_size', type=int, default=CACHE_MAX_BYTES // (1024 * 1024),
+                        help=f'Size limit of .cache/ in MiB. The least recently used entries are evicted after the run. '
+                             f'Default: {CACHE_MAX_BYTES // (1024 * 1024)}')
     args = parser.parse_args()
 
+    cache.enabled = args.cache
+    cache.max_bytes = args.cache_size * 1024 * 1024
+    if args.seed is not None:
+        torch.manual_seed(args.seed)
+
     # All the generated headers will go into 'inc/data' so create directory first
     os.makedirs('inc/data', exist_ok=True)
 
-    create_layer(args.cin, args.cout, args.spatial_dimensions, args.kernel_shape)
+    if args.fused_dw_pw:
+        create_fused_block(args.cin, args.cout, args.spatial_dimensions, args.fused_tile, batch=args.batch)
+    else:
+        create_layer(args.cin, args.cout, args.spatial_dimensions, args.kernel_shape, batch=args.batch, l1_budget=args.l1_budget, epilogue=args.epilogue,
+                     compress_weights=args.compress_weights, groups=args.groups, dilation=args.dilation,
+                     residual=args.residual, skip_step=tuple(args.skip_step))
+
+    cache.report()
+    cache.prune()
@@ -0,0 +1,168 @@
+#include <pmsis.h>
+
+#include "dims.h"
+
+#if FUSED_DW_PW
+
+#include "pulp_nnx.h"
+#include "pulp_nnx_util.h"
+#include "input.h"
+#include "output.h"
+#include "weights.h"
+#include "weights_pw.h"
+#include "normalization_scale.h"
+#include "normalization_scale_pw.h"
+#include "fused_block.h"
+#include "layer_util.h"
+
+PI_L1 uint8_t fused_scratch[FUSED_TILE * FUSED_TILE * INPUT_CHANNEL] __attribute__((aligned(4)));
+
+void fused_block(void *args) {
+    layer_info();
+
+    nnx_dev_t nnx_dev = NNX_DEV_DEFAULT;
+
+    nnx_gvsoc_logging_activate(&nnx_dev);
+
+    nnx_weights_t nnx_weights_dw = {
+        .data = weights,
+        .height = WEIGHTS_KERNEL_HEIGHT,
+        .width = WEIGHTS_KERNEL_WIDTH,
+        .depth = WEIGHTS_CHANNEL_IN,
+        .n_weights = WEIGHTS_CHANNEL_OUT,
+        .bitwidth = 8,
+        .offset_factor = 0,
+        .offset_mode = weightOffsetModeLayerWise
+    };
+
+    nnx_weights_t nnx_weights_pw = {
+        .data = weights_pw,
+        .height = WEIGHTS_PW_KERNEL_HEIGHT,
+        .width = WEIGHTS_PW_KERNEL_WIDTH,
+        .depth = WEIGHTS_PW_CHANNEL_IN,
+        .n_weights = WEIGHTS_PW_CHANNEL_OUT,
+        .bitwidth = 8,
+        .offset_factor = 0,
+        .offset_mode = weightOffsetModeLayerWise
+    };
+
+    nnx_feature_t nnx_input = {
+        .data = input,
+        .height = INPUT_HEIGHT,
+        .width = INPUT_WIDTH,
+        .depth = INPUT_CHANNEL,
+        .bitwidth = featureBitwidth8Bit
+    };
+
+    // Dimensions of the intermediate tensor, only a tile of it is ever stored
+    nnx_feature_t nnx_intermediate = {
+        .data = fused_scratch,
+        .height = OUTPUT_HEIGHT,
+        .width = OUTPUT_WIDTH,
+        .depth = INPUT_CHANNEL,
+        .bitwidth = featureBitwidth8Bit
+    };
+
+    nnx_feature_t nnx_output = {
+        .data = output,
+        .height = OUTPUT_HEIGHT,
+        .width = OUTPUT_WIDTH,
+        .depth = OUTPUT_CHANNEL,
+        .bitwidth = featureBitwidth8Bit
+    };
+
+    const nnx_norm_t nnx_norm = {
+        .mode  = normMode32Bit,
+        .flag_bias  = FLAG_UNUSED,
+        .flag_shift = FLAG_UNUSED
+    };
+
+    const nnx_quant_t nnx_quant_dw = {
+        .shift_amount = OUTSHIFT,
+        .mode = quantMode8Bit,
+        .function = quantFunctionRelu,
+        .flag_rounding = FLAG_UNUSED
+    };
+
+    const nnx_quant_t nnx_quant_pw = {
+        .shift_amount = OUTSHIFT_PW,
+        .mode = quantMode8Bit,
+        .function = quantFunctionRelu,
+        .flag_rounding = FLAG_UNUSED
+    };
+
+    const nnx_padding_t nnx_padding = { 0 };
+
+    const int nnx_stride = 1;
+
+    pi_perf_conf(1<<PI_PERF_CYCLES);
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+
+    nnx_task_t nnx_task_dw, nnx_task_pw;
+    nnx_task_init(&nnx_task_dw);
+    nnx_task_init(&nnx_task_pw);
+
+    int err = nnx_conv_3x3_dw(&nnx_dev, &nnx_task_dw.cfg, nnx_weights_dw, nnx_input, nnx_intermediate, nnx_padding, nnx_stride);
+    err |= nnx_conv_1x1(&nnx_dev, &nnx_task_pw.cfg, nnx_weights_pw, nnx_intermediate, nnx_output, nnx_padding, nnx_stride);
+
+    nnx_norm_quant(&nnx_task_dw.cfg, nnx_norm, nnx_quant_dw);
+    nnx_pad_input(&nnx_task_dw.cfg, nnx_padding);
+    nnx_norm_quant(&nnx_task_pw.cfg, nnx_norm, nnx_quant_pw);
+    nnx_pad_input(&nnx_task_pw.cfg, nnx_padding);
+
+    if (err != 0) {
+        printf("Error while setting up the nnx: %d\n", err);
+        pmsis_exit(-2);
+    }
+
+    nnx_task_dw.weights_ptr = (uint32_t)weights;
+    nnx_task_dw.scale_ptr = (uint32_t)normalization_scale;
+    nnx_task_pw.weights_ptr = (uint32_t)weights_pw;
+    nnx_task_pw.scale_ptr = (uint32_t)normalization_scale_pw;
+
+    const nnx_tile_plan_t nnx_tile_plan = {
+        .height = FUSED_TILE,
+        .width = FUSED_TILE
+    };
+
+    nnx_fused_block_t nnx_block = {
+        .dev = &nnx_dev,
+        .dw_task = &nnx_task_dw,
+        .pw_task = &nnx_task_pw,
+        .input = nnx_input,
+        .output = nnx_output,
+        .scratch = fused_scratch
+    };
+
+    const int setup_cycles = pi_perf_read(PI_PERF_CYCLES);
+
+    nnx_session_t nnx_session;
+    nnx_session_open(&nnx_dev, &nnx_session, NNX_SESSION_NO_TIMEOUT);
+    nnx_session_begin(&nnx_dev, &nnx_session);
+
+    nnx_trace_reset();
+
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+
+    for (int i = 0; i < BATCH; i++) {
+        nnx_block.input.data = input + i * INPUT_FRAME_SIZE;
+        nnx_block.output.data = output + i * OUTPUT_FRAME_SIZE;
+        nnx_run_fused_dw_pw(&nnx_block, nnx_tile_plan);
+    }
+
+    const int cycles = pi_perf_read(PI_PERF_CYCLES);
+
+    nnx_session_close(&nnx_dev, &nnx_session);
+
+    check_output();
+
+    layer_stats(setup_cycles, cycles);
+
+    nnx_trace_dump();
+}
+
+#endif  // FUSED_DW_PW
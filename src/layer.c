@@ -1,31 +1,46 @@
 #include <pmsis.h>
 
+#include "dims.h"
+
+#if !FUSED_DW_PW
+
 #include "pulp_nnx.h"
 #include "pulp_nnx_util.h"
-#include "dims.h"
 #include "input.h"
 #include "output.h"
 #include "weights.h"
 #include "normalization_scale.h"
+#if TILED
+#include "tile_plan.h"
+#endif
 #include "layer.h"
 #include "layer_util.h"
+#if EPILOGUE == EPILOGUE_ADD
+#include "skip.h"
+#elif EPILOGUE == EPILOGUE_MAXPOOL
+#include "conv_output.h"
+#endif
 
 void layer(void *args) {
     layer_info();
 
-    nnx_gvsoc_logging_activate();
+    nnx_dev_t nnx_dev = NNX_DEV_DEFAULT;
+
+    nnx_gvsoc_logging_activate(&nnx_dev);
 
     nnx_weights_t nnx_weights = {
+        .data = WEIGHTS,
         .height = WEIGHTS_KERNEL_HEIGHT,
         .width = WEIGHTS_KERNEL_WIDTH,
-        .depth = WEIGHTS_CHANNEL_IN,
-        .n_weights = WEIGHTS_CHANNEL_OUT,
+        .depth = JOB_CHANNEL_IN,
+        .n_weights = JOB_CHANNEL_OUT,
         .bitwidth = 8,
         .offset_factor = 0,
         .offset_mode = weightOffsetModeLayerWise
     };
 
     nnx_feature_t nnx_input = {
+        .data = input,
         .height = INPUT_HEIGHT,
         .width = INPUT_WIDTH,
         .depth = INPUT_CHANNEL,
@@ -33,6 +48,7 @@ void layer(void *args) {
     };
 
     nnx_feature_t nnx_output = {
+        .data = CONV_OUTPUT,
         .height = OUTPUT_HEIGHT,
         .width = OUTPUT_WIDTH,
         .depth = OUTPUT_CHANNEL,
@@ -58,17 +74,26 @@ void layer(void *args) {
 
     const int nnx_stride = 1;
 
+    pi_perf_conf(1<<PI_PERF_CYCLES);
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+
     nnx_task_t nnx_task;
     nnx_task_init(&nnx_task);
 
+    // Jobs of a grouped layer see only their channels of the input and output
+    const nnx_feature_t nnx_job_input = nnx_view_channels(&nnx_input, 0, JOB_CHANNEL_IN);
+    const nnx_feature_t nnx_job_output = nnx_view_channels(&nnx_output, 0, JOB_CHANNEL_OUT);
+
     int err;
-    int is_depthwise = WEIGHTS_CHANNEL_IN == 1 && INPUT_CHANNEL != 1;
+    int is_depthwise = GROUPS == 1 && WEIGHTS_CHANNEL_IN == 1 && INPUT_CHANNEL != 1;
     if (WEIGHTS_KERNEL_WIDTH == 3 && !is_depthwise)
-        err = nnx_conv_3x3(&nnx_task.cfg, nnx_weights, nnx_input, nnx_output, nnx_padding, nnx_stride);
+        err = nnx_conv_3x3(&nnx_dev, &nnx_task.cfg, nnx_weights, nnx_job_input, nnx_job_output, nnx_padding, nnx_stride);
     else if (WEIGHTS_KERNEL_WIDTH == 3 && is_depthwise)
-        err = nnx_conv_3x3_dw(&nnx_task.cfg, nnx_weights, nnx_input, nnx_output, nnx_padding, nnx_stride);
+        err = nnx_conv_3x3_dw(&nnx_dev, &nnx_task.cfg, nnx_weights, nnx_job_input, nnx_job_output, nnx_padding, nnx_stride);
     else if (WEIGHTS_KERNEL_WIDTH == 1 && !is_depthwise)
-        err = nnx_conv_1x1(&nnx_task.cfg, nnx_weights, nnx_input, nnx_output, nnx_padding, nnx_stride);
+        err = nnx_conv_1x1(&nnx_dev, &nnx_task.cfg, nnx_weights, nnx_job_input, nnx_job_output, nnx_padding, nnx_stride);
     else {
         printf("Wrong layer arguments (ks:%d, dw:%s)\n", WEIGHTS_KERNEL_WIDTH, is_depthwise ? "true" : "false");
         pmsis_exit(-1);
@@ -76,35 +101,301 @@ void layer(void *args) {
 
     nnx_norm_quant(&nnx_task.cfg, nnx_norm, nnx_quant);
     nnx_pad_input(&nnx_task.cfg, nnx_padding);
+#if RESIDUAL
+    nnx_streamin(&nnx_task.cfg, 1);
+#endif
 
     if (err != 0) {
         printf("Error while setting up the nnx: %d\n", err);
         pmsis_exit(-2);
     }
 
-    nnx_task.infeat_ptr = (uint32_t)input;
-    nnx_task.outfeat_ptr = (uint32_t)output;
-    nnx_task.weights_ptr = (uint32_t)weights;
+    nnx_task.weights_ptr = (uint32_t)WEIGHTS;
     nnx_task.scale_ptr = (uint32_t)normalization_scale;
     nnx_task.scale_bias_ptr = (uint32_t)NULL;
     nnx_task.scale_shift_ptr = (uint32_t)NULL;
 
-    nnx_init();
-    nnx_acquire();
-    nnx_offload(&nnx_task);
+#if GROUPS > 1
+    nnx_grouped_conv_t nnx_grouped = {
+        .dev = &nnx_dev,
+        .task = &nnx_task,
+        .input = nnx_input,
+        .output = nnx_output,
+        .weights = weights,
+        .weights_job_size = WEIGHTS_JOB_SIZE,
+        .scale = normalization_scale,
+        .scale_bytes = 4,
+        .n_jobs = N_JOBS
+    };
+#endif
 
-    pi_perf_conf(1<<PI_PERF_CYCLES);
+#if DILATION > 1
+    nnx_dilated_conv_t nnx_dilated = {
+        .dev = &nnx_dev,
+        .task = &nnx_task,
+        .input = nnx_input,
+        .output = nnx_output,
+        .dilation = DILATION
+    };
+#endif
+
+#if RESIDUAL
+    // The output buffer holds the skip tensor, which the residual overwrites
+    nnx_residual_conv_t nnx_residual = {
+        .dev = &nnx_dev,
+        .task = &nnx_task,
+        .input = nnx_input,
+        .skip = nnx_output,
+        .output = nnx_output,
+        .skip_rescale = { .multiplier = SKIP_MULTIPLIER, .shift = SKIP_SHIFT },
+        .n_cores = NUM_CORES
+    };
+#endif
+
+#if TILED
+    const nnx_tile_plan_t nnx_tile_plan = {
+        .height = TILE_HEIGHT,
+        .width = TILE_WIDTH,
+        .depth = TILE_DEPTH,
+        .order = TILE_ORDER
+    };
+
+#if COMPRESSED_WEIGHTS
+    const nnx_compressed_weights_t nnx_compressed_weights = {
+        .bitmap = weights_bitmap,
+        .offsets = (uint32_t *)weights_offsets,
+        .literals = weights_literals,
+        .plane_size = WEIGHTS_PLANE_SIZE,
+        .planes_per_group = WEIGHTS_PLANES_PER_GROUP,
+        .n_groups = WEIGHTS_CHANNEL_OUT,
+        .n_cores = NUM_CORES
+    };
+#endif
+
+    // The tile buffers of both contexts share the arena planned by the generator
+    nnx_arena_t nnx_arena;
+    nnx_arena_init(&nnx_arena, tile_arena, TILE_ARENA_SIZE);
+
+    nnx_tiled_layer_t nnx_tiled_layer = {
+        .dev = &nnx_dev,
+        .task = &nnx_task,
+        .input = nnx_input,
+        .output = nnx_output,
+        .weights = nnx_weights,
+        .scale = normalization_scale,
+        .scale_bytes = 4,
+#if COMPRESSED_WEIGHTS
+        .compressed = &nnx_compressed_weights,
+        .buffer = {
+            { TILE_BUFFER(&nnx_arena, INPUT_0), TILE_BUFFER(&nnx_arena, WEIGHTS_0), TILE_BUFFER(&nnx_arena, SCALE_0),
+              TILE_BUFFER(&nnx_arena, OUTPUT_0), TILE_BUFFER(&nnx_arena, COMPRESSED_0) },
+            { TILE_BUFFER(&nnx_arena, INPUT_1), TILE_BUFFER(&nnx_arena, WEIGHTS_1), TILE_BUFFER(&nnx_arena, SCALE_1),
+              TILE_BUFFER(&nnx_arena, OUTPUT_1), TILE_BUFFER(&nnx_arena, COMPRESSED_1) }
+        }
+#else
+        .buffer = {
+            { TILE_BUFFER(&nnx_arena, INPUT_0), TILE_BUFFER(&nnx_arena, WEIGHTS_0),
+              TILE_BUFFER(&nnx_arena, SCALE_0), TILE_BUFFER(&nnx_arena, OUTPUT_0) },
+            { TILE_BUFFER(&nnx_arena, INPUT_1), TILE_BUFFER(&nnx_arena, WEIGHTS_1),
+              TILE_BUFFER(&nnx_arena, SCALE_1), TILE_BUFFER(&nnx_arena, OUTPUT_1) }
+        }
+#endif
+    };
+
+    // A plan that does not fit the arena leaves buffers unplaced
+    for (int i = 0; i < NNX_CONTEXT_SIZE; i++) {
+        const nnx_tile_buffer_t *buffer = &nnx_tiled_layer.buffer[i];
+        if (buffer->input == NULL || buffer->weights == NULL || buffer->scale == NULL || buffer->output == NULL
+#if COMPRESSED_WEIGHTS
+            || buffer->compressed == NULL
+#endif
+           ) {
+            printf("Error while placing the tile buffers of context %d in the L1 arena\n", i);
+            pmsis_exit(-3);
+        }
+    }
+
+    arena_info(&nnx_arena);
+
+#if EPILOGUE == EPILOGUE_CLIP
+    nnx_clip_args_t nnx_epilogue_args = {
+        .low = EPILOGUE_CLIP_LOW,
+        .high = EPILOGUE_CLIP_HIGH
+    };
+#define EPILOGUE_FN nnx_epilogue_clip
+#elif EPILOGUE == EPILOGUE_ADD
+    nnx_add_args_t nnx_epilogue_args = {
+        .skip = {
+            .data = skip,
+            .height = OUTPUT_HEIGHT,
+            .width = OUTPUT_WIDTH,
+            .depth = OUTPUT_CHANNEL,
+            .bitwidth = featureBitwidth8Bit
+        }
+    };
+#define EPILOGUE_FN nnx_epilogue_add
+#elif EPILOGUE == EPILOGUE_MAXPOOL
+    nnx_maxpool_args_t nnx_epilogue_args = {
+        .output = {
+            .data = output,
+            .height = EPILOGUE_OUTPUT_HEIGHT,
+            .width = EPILOGUE_OUTPUT_WIDTH,
+            .depth = EPILOGUE_OUTPUT_CHANNEL,
+            .bitwidth = featureBitwidth8Bit
+        }
+    };
+#define EPILOGUE_FN nnx_epilogue_maxpool2x2
+#endif
+
+#if EPILOGUE != EPILOGUE_NONE
+    const nnx_epilogue_t nnx_epilogue = {
+        .fn = EPILOGUE_FN,
+        .arg = &nnx_epilogue_args,
+        .n_cores = NUM_CORES
+    };
+#endif
+#endif  // TILED
+
+    const int setup_cycles = pi_perf_read(PI_PERF_CYCLES);
+
+    // Overhead paid by every layer that brings the NE16 up and down by itself
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+
+    nnx_init(&nnx_dev);
+    nnx_term(&nnx_dev);
+
+    const int init_term_cycles = pi_perf_read(PI_PERF_CYCLES);
+
+    // Gates the clock after one idle poll, so both cases of begin can be measured
+    nnx_session_t nnx_session;
+    nnx_session_open(&nnx_dev, &nnx_session, 1);
+
+    // Overhead paid by every layer of an open session whose clock is still on
     pi_perf_stop();
     pi_perf_reset();
     pi_perf_start();
 
-    nnx_run();
+    nnx_session_begin(&nnx_dev, &nnx_session);
+
+    const int session_warm_cycles = pi_perf_read(PI_PERF_CYCLES);
+
+    // The first poll marks the session idle, the second one gates the clock
+    nnx_session_poll(&nnx_dev, &nnx_session, 0);
+    nnx_session_poll(&nnx_dev, &nnx_session, 2);
+
+    // Overhead paid by the first layer after the session went idle
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+
+    nnx_session_begin(&nnx_dev, &nnx_session);
+
+    const int session_cold_cycles = pi_perf_read(PI_PERF_CYCLES);
+
+#if EPILOGUE != EPILOGUE_NONE
+    // Baseline: the layer followed by the epilogue as a separate pass over
+    // the whole output
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+
+    nnx_run_tiled(&nnx_tiled_layer, nnx_tile_plan);
+
+    const int conv_cycles = pi_perf_read(PI_PERF_CYCLES);
+
+    const nnx_tile_t nnx_whole_output = {
+        .data = CONV_OUTPUT,
+        .height = OUTPUT_HEIGHT,
+        .width = OUTPUT_WIDTH,
+        .depth = OUTPUT_CHANNEL
+    };
+
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+
+    nnx_run_epilogue(&nnx_epilogue, &nnx_whole_output);
+
+    const int pass_cycles = pi_perf_read(PI_PERF_CYCLES);
+
+    nnx_tiled_layer.epilogue = nnx_epilogue;
+#endif
+
+    nnx_trace_reset();
+
+    pi_perf_stop();
+    pi_perf_reset();
+    pi_perf_start();
+
+#if TILED
+    nnx_tiled_layer.stats = (nnx_tiled_stats_t){ 0 };
+
+    for (int i = 0; i < BATCH; i++) {
+        nnx_tiled_layer.input.data = input + i * INPUT_FRAME_SIZE;
+#if EPILOGUE == EPILOGUE_MAXPOOL
+        // Only the pooled output is stored
+        nnx_tiled_layer.output.data = NULL;
+#else
+        nnx_tiled_layer.output.data = output + i * OUTPUT_FRAME_SIZE;
+#endif
+        nnx_run_tiled(&nnx_tiled_layer, nnx_tile_plan);
+    }
+#elif GROUPS > 1
+    for (int i = 0; i < BATCH; i++) {
+        nnx_grouped.input.data = input + i * INPUT_FRAME_SIZE;
+        nnx_grouped.output.data = output + i * OUTPUT_FRAME_SIZE;
+        err = nnx_run_grouped(&nnx_grouped);
+        if (err != 0) {
+            printf("Error while running the grouped convolution: %d\n", err);
+            pmsis_exit(-2);
+        }
+    }
+#elif DILATION > 1
+    for (int i = 0; i < BATCH; i++) {
+        nnx_dilated.input.data = input + i * INPUT_FRAME_SIZE;
+        nnx_dilated.output.data = output + i * OUTPUT_FRAME_SIZE;
+        err = nnx_run_dilated(&nnx_dilated);
+        if (err != 0) {
+            printf("Error while running the dilated convolution: %d\n", err);
+            pmsis_exit(-2);
+        }
+    }
+#elif RESIDUAL
+    for (int i = 0; i < BATCH; i++) {
+        nnx_residual.input.data = input + i * INPUT_FRAME_SIZE;
+        nnx_residual.skip.data = output + i * OUTPUT_FRAME_SIZE;
+        nnx_residual.output.data = output + i * OUTPUT_FRAME_SIZE;
+        nnx_run_residual(&nnx_residual);
+    }
+#else
+    // The input and output pointers are set per frame
+    nnx_run_batch(&nnx_dev, &nnx_task,
+                  (uint32_t)input, INPUT_FRAME_SIZE,
+                  (uint32_t)output, OUTPUT_FRAME_SIZE,
+                  BATCH);
+#endif
 
     const int cycles = pi_perf_read(PI_PERF_CYCLES);
 
-    nnx_term();
+    nnx_session_close(&nnx_dev, &nnx_session);
 
     check_output();
 
-    layer_stats(cycles);
+    layer_stats(setup_cycles, cycles);
+    session_stats(init_term_cycles, session_warm_cycles, session_cold_cycles);
+
+#if EPILOGUE != EPILOGUE_NONE
+    epilogue_stats(conv_cycles, pass_cycles, cycles);
+#endif
+
+#if COMPRESSED_WEIGHTS
+    compression_stats(&nnx_tiled_layer.stats, BATCH * DIVNCEIL(OUTPUT_HEIGHT, TILE_HEIGHT)
+                      * DIVNCEIL(OUTPUT_WIDTH, TILE_WIDTH) * DIVNCEIL(OUTPUT_CHANNEL, TILE_DEPTH));
+#endif
+
+    nnx_trace_dump();
 }
+
+#endif  // !FUSED_DW_PW
@@ -1,6 +1,8 @@
 #include <pmsis.h>
 
+#include "dims.h"
 #include "layer.h"
+#include "fused_block.h"
 
 void app_kickoff(void *args) {
     struct pi_device cl_dev;
@@ -13,7 +15,11 @@ void app_kickoff(void *args) {
     pi_open_from_conf(&cl_dev, &cl_conf);
     if (pi_cluster_open(&cl_dev))
         pmsis_exit(-1);
+#if FUSED_DW_PW
+    pi_cluster_send_task_to_cl(&cl_dev, pi_cluster_task(&cl_task, fused_block, NULL));
+#else
     pi_cluster_send_task_to_cl(&cl_dev, pi_cluster_task(&cl_task, layer, NULL));
+#endif
     pi_cluster_close(&cl_dev);
 
     pmsis_exit(0);
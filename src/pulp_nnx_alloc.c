@@ -0,0 +1,54 @@
+/*
+ * pulp_nnx_alloc.c
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nnx_alloc.h"
+
+void nnx_arena_init(nnx_arena_t *arena, uint8_t *base, const uint32_t size) {
+  arena->base = base;
+  arena->size = size;
+  arena->top = 0;
+  arena->peak = 0;
+}
+
+void *nnx_arena_place(nnx_arena_t *arena, const uint32_t offset, const uint32_t size) {
+  if (offset + size > arena->size || offset % NNX_ARENA_ALIGNMENT != 0)
+    return NULL;
+
+  // Bump allocations go after the planned buffers
+  if (offset + size > arena->top)
+    arena->top = offset + size;
+  if (arena->top > arena->peak)
+    arena->peak = arena->top;
+
+  return arena->base + offset;
+}
+
+void *nnx_arena_alloc(nnx_arena_t *arena, const uint32_t size, const uint32_t alignment) {
+  const uint32_t offset = (arena->top + alignment - 1) / alignment * alignment;
+
+  if (offset + size > arena->size)
+    return NULL;
+
+  arena->top = offset + size;
+  if (arena->top > arena->peak)
+    arena->peak = arena->top;
+
+  return arena->base + offset;
+}
@@ -0,0 +1,65 @@
+/*
+ * pulp_nnx_decompress.c
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nnx_decompress.h"
+#include "pulp_nnx_trace.h"
+
+typedef struct {
+  const nnx_compressed_weights_t *weights;
+  const uint8_t *src;
+  uint8_t *dst;
+  int g0, n;
+} nnx_decompress_fork_t;
+
+// Groups are independent thanks to the offsets, so they are interleaved
+// between the cores.
+static void nnx_decompress_entry(void *arg) {
+  const nnx_decompress_fork_t *fork = (nnx_decompress_fork_t *)arg;
+  const nnx_compressed_weights_t *weights = fork->weights;
+  const int plane_size = weights->plane_size;
+  const int n_planes = weights->planes_per_group;
+  const uint32_t base = weights->offsets[fork->g0];
+
+  for (int i = pi_core_id(); i < fork->n; i += pi_cl_team_nb_cores()) {
+    const int g = fork->g0 + i;
+    const uint8_t *src = fork->src + weights->offsets[g] - base;
+    uint8_t *dst = fork->dst + i * n_planes * plane_size;
+
+    for (int p = g * n_planes; p < (g + 1) * n_planes; p++) {
+      const int stored = (weights->bitmap[p >> 3] >> (p & 7)) & 1;
+
+      for (int j = 0; j < plane_size; j++)
+        dst[j] = stored ? src[j] : 0;
+
+      if (stored)
+        src += plane_size;
+      dst += plane_size;
+    }
+  }
+}
+
+void nnx_decompress_weights(const nnx_compressed_weights_t *weights,
+                            const uint8_t *src, uint8_t *dst,
+                            const int g0, const int n) {
+  nnx_decompress_fork_t fork = { .weights = weights, .src = src, .dst = dst, .g0 = g0, .n = n };
+  NNX_TRACE_EVENT(traceEventDecompressStart, n);
+  pi_cl_team_fork(weights->n_cores, nnx_decompress_entry, &fork);
+  NNX_TRACE_EVENT(traceEventDecompressFinish, 0);
+}
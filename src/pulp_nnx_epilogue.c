@@ -0,0 +1,102 @@
+/*
+ * pulp_nnx_epilogue.c
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nnx_epilogue.h"
+#include "pulp_nnx_trace.h"
+
+typedef struct {
+  const nnx_epilogue_t *epilogue;
+  const nnx_tile_t *tile;
+} nnx_epilogue_fork_t;
+
+static void nnx_epilogue_entry(void *arg) {
+  nnx_epilogue_fork_t *fork = (nnx_epilogue_fork_t *)arg;
+  fork->epilogue->fn(fork->tile, fork->epilogue->arg);
+}
+
+void nnx_run_epilogue(const nnx_epilogue_t *epilogue, const nnx_tile_t *tile) {
+  nnx_epilogue_fork_t fork = { .epilogue = epilogue, .tile = tile };
+  NNX_TRACE_EVENT(traceEventEpilogueStart, tile->height * tile->width * tile->depth);
+  pi_cl_team_fork(epilogue->n_cores, nnx_epilogue_entry, &fork);
+  NNX_TRACE_EVENT(traceEventEpilogueFinish, 0);
+}
+
+// Rows [*start, *end) of the tile assigned to the calling core
+static void nnx_epilogue_rows(const int height, int *start, int *end) {
+  const int n_cores = pi_cl_team_nb_cores();
+  const int chunk = DIVNCEIL(height, n_cores);
+  *start = pi_core_id() * chunk;
+  *end = *start + chunk < height ? *start + chunk : height;
+}
+
+void nnx_epilogue_clip(const nnx_tile_t *tile, void *arg) {
+  const nnx_clip_args_t *clip = (nnx_clip_args_t *)arg;
+  const int row_size = tile->width * tile->depth;
+  int start, end;
+  nnx_epilogue_rows(tile->height, &start, &end);
+
+  for (uint8_t *p = tile->data + start * row_size; p < tile->data + end * row_size; p++) {
+    if (*p < clip->low)
+      *p = clip->low;
+    else if (*p > clip->high)
+      *p = clip->high;
+  }
+}
+
+void nnx_epilogue_add(const nnx_tile_t *tile, void *arg) {
+  const nnx_feature_t *skip = &((nnx_add_args_t *)arg)->skip;
+  int start, end;
+  nnx_epilogue_rows(tile->height, &start, &end);
+
+  for (int h = start; h < end; h++) {
+    for (int w = 0; w < tile->width; w++) {
+      uint8_t *out = tile->data + (h * tile->width + w) * tile->depth;
+      const uint8_t *in = (uint8_t *)skip->data
+                          + ((tile->h0 + h) * nnx_row_stride(skip) + tile->w0 + w) * nnx_channel_stride(skip) + tile->k0;
+      for (int k = 0; k < tile->depth; k++) {
+        const int sum = out[k] + in[k];
+        out[k] = sum > 255 ? 255 : sum;
+      }
+    }
+  }
+}
+
+void nnx_epilogue_maxpool2x2(const nnx_tile_t *tile, void *arg) {
+  const nnx_feature_t *pooled = &((nnx_maxpool_args_t *)arg)->output;
+  const int row_size = tile->width * tile->depth;
+  int start, end;
+  nnx_epilogue_rows(tile->height / 2, &start, &end);
+
+  for (int h = start; h < end; h++) {
+    for (int w = 0; w < tile->width / 2; w++) {
+      const uint8_t *in = tile->data + (2 * h * tile->width + 2 * w) * tile->depth;
+      uint8_t *out = (uint8_t *)pooled->data
+                     + ((tile->h0 / 2 + h) * nnx_row_stride(pooled) + tile->w0 / 2 + w) * nnx_channel_stride(pooled)
+                     + tile->k0;
+      for (int k = 0; k < tile->depth; k++) {
+        uint8_t max = in[k];
+        if (in[k + tile->depth] > max) max = in[k + tile->depth];
+        if (in[k + row_size] > max) max = in[k + row_size];
+        if (in[k + row_size + tile->depth] > max) max = in[k + row_size + tile->depth];
+        out[k] = max;
+      }
+    }
+  }
+}
@@ -20,8 +20,8 @@
 
 #include "pmsis.h"
 #include "pulp_nnx_hal.h"
-
-static int qw, weight_d0_stride, outbytes, stride_shift;
+#include "pulp_nnx_view.h"
+#include "pulp_nnx_trace.h"
 
 // TODO For all the following functions we use __builtin_pulp_OffsetedWrite and
 // __builtin_pulp_OffsetedRead instead of classic load/store because otherwise
@@ -31,93 +31,159 @@ static int qw, weight_d0_stride, outbytes, stride_shift;
 // __builtin_pulp_OffsetedX not defined - needs further investigation... (too
 // old PULP toolchain? used v1.0.16) It is used inside PULP-SDK...
 
-void nnx_init() {
-  NE16_CG_ENABLE();
-  NE16_SETPRIORITY_NE16();
-  NE16_SET_MAXSTALL(0);
-  nnx_soft_clear();
+void nnx_init(nnx_dev_t *dev) {
+  const nnx_arbitration_t arbitration = NNX_ARBITRATION_DEFAULT;
+  NE16_CG_ENABLE(dev);
+  nnx_set_arbitration(dev, arbitration);
+  nnx_soft_clear(dev);
+}
+
+void nnx_term(nnx_dev_t *dev) {
+  nnx_soft_clear(dev);
+  NE16_SETPRIORITY_CORE(dev);
+  NE16_RESET_MAXSTALL(dev);
+  NE16_CG_DISABLE(dev);
+}
+
+void nnx_set_arbitration(nnx_dev_t *dev, const nnx_arbitration_t arbitration) {
+  if (arbitration.owner == priorityOwnerNe16)
+    NE16_SETPRIORITY_NE16(dev);
+  else
+    NE16_SETPRIORITY_CORE(dev);
+  NE16_RESET_MAXSTALL(dev);
+  NE16_SET_MAXSTALL(dev, arbitration.max_stall);
+}
+
+void nnx_session_open(nnx_dev_t *dev, nnx_session_t *session, const uint32_t idle_timeout) {
+  nnx_init(dev);
+  session->clock_enabled = 1;
+  session->active = 1;
+  session->idle_timeout = idle_timeout;
+  session->last_active = 0;
+}
+
+// Called before the jobs of a layer. Only ungates the clock if the session
+// was idle, the configuration and the context registers are kept.
+void nnx_session_begin(nnx_dev_t *dev, nnx_session_t *session) {
+  if (!session->clock_enabled) {
+    NE16_CG_ENABLE(dev);
+    session->clock_enabled = 1;
+  }
+  session->active = 1;
+}
+
+// Gates the clock once the NE16 has been idle for longer than the timeout
+void nnx_session_poll(nnx_dev_t *dev, nnx_session_t *session, const uint32_t now) {
+  if (!session->clock_enabled || session->idle_timeout == NNX_SESSION_NO_TIMEOUT)
+    return;
+
+  if (session->active || !nnx_empty(dev)) {
+    session->active = 0;
+    session->last_active = now;
+  } else if (now - session->last_active > session->idle_timeout) {
+    NE16_CG_DISABLE(dev);
+    session->clock_enabled = 0;
+  }
+}
+
+// Only needed to abort queued jobs, e.g. after an error
+void nnx_session_clear(nnx_dev_t *dev, nnx_session_t *session) {
+  nnx_session_begin(dev, session);
+  nnx_soft_clear(dev);
 }
 
-void nnx_term() {
-  nnx_soft_clear();
-  NE16_SETPRIORITY_CORE();
-  NE16_RESET_MAXSTALL();
-  NE16_CG_DISABLE();
+void nnx_session_close(nnx_dev_t *dev, nnx_session_t *session) {
+  nnx_session_begin(dev, session);
+  nnx_term(dev);
+  session->clock_enabled = 0;
 }
 
-int nnx_empty() {
-  return !NE16_READ(NE16_STATUS);
+int nnx_empty(nnx_dev_t *dev) {
+  return !NE16_READ(dev, NE16_STATUS);
 }
 
-int nnx_full() {
-  return NE16_READ(NE16_STATUS) == NE16_STATUS_FULL;
+int nnx_full(nnx_dev_t *dev) {
+  return NE16_READ(dev, NE16_STATUS) == NE16_STATUS_FULL;
 }
 
-uint8_t nnx_job_id() {
-  return NE16_READ(NE16_RUNNING_JOB);
+uint8_t nnx_job_id(nnx_dev_t *dev) {
+  return NE16_READ(dev, NE16_RUNNING_JOB);
 }
 
-void nnx_soft_clear() {
-  NE16_WRITE(NE16_SOFT_CLEAR, 0);
+void nnx_soft_clear(nnx_dev_t *dev) {
+  NE16_WRITE(dev, NE16_SOFT_CLEAR, 0);
   for (volatile int i = 0; i < 10; i++)
     ;
 }
 
-int nnx_acquire_polled() {
+int nnx_acquire_polled(nnx_dev_t *dev) {
   int job_id = -1;
-  while ((job_id = NE16_READ(NE16_ACQUIRE)) < 0) printf("job id: %d\n", job_id);
+  while ((job_id = NE16_READ(dev, NE16_ACQUIRE)) < 0) printf("job id: %d\n", job_id);
   return job_id;
 }
 
-int nnx_acquire() {
+int nnx_acquire(nnx_dev_t *dev) {
   int job_id = -1;
-  NE16_BARRIER_ACQUIRE(job_id);
+  NE16_BARRIER_ACQUIRE(dev, job_id);
+  NNX_TRACE_EVENT(traceEventAcquire, job_id);
   return job_id;
 }
 
-void nnx_offload(nnx_task_t *task) {
+void nnx_offload(nnx_dev_t *dev, nnx_task_t *task) {
+  NNX_TRACE_EVENT(traceEventOffload, 0);
   int *task_data = (int *)task;
   for (int i = 0; i < sizeof(nnx_task_t) / 4; ++i) {
-    NE16_WRITE_IO_REG(i * 4, task_data[i]);
+    NE16_WRITE_IO_REG(dev, i * 4, task_data[i]);
   }
 }
 
-void nnx_offload_ptr(nnx_task_t *task) {
+void nnx_offload_ptr(nnx_dev_t *dev, nnx_task_t *task) {
+  NNX_TRACE_EVENT(traceEventOffload, 0);
   int *task_data = (int *)task;
   for (int i = 0; i < 6; ++i) {
-    NE16_WRITE_IO_REG(i * 4, task_data[i]);
+    NE16_WRITE_IO_REG(dev, i * 4, task_data[i]);
   }
 }
 
-void nnx_run_async() {
-  NE16_WRITE(NE16_TRIGGER, 0);
+void nnx_run_async(nnx_dev_t *dev) {
+  NNX_TRACE_EVENT(traceEventTrigger, 0);
+  NE16_WRITE(dev, NE16_TRIGGER, 0);
 }
 
-void nnx_run() {
-  nnx_run_async();
-  nnx_wait_empty();
+void nnx_run(nnx_dev_t *dev) {
+  nnx_run_async(dev);
+  nnx_wait_empty(dev);
 }
 
-void nnx_commit() {
-  NE16_WRITE(NE16_TRIGGER, 1); // commit, no trigger
+void nnx_commit(nnx_dev_t *dev) {
+  NE16_WRITE(dev, NE16_TRIGGER, 1); // commit, no trigger
 }
 
-void nnx_busywait() {
-  NE16_BUSYWAIT();
+// Completion events are recorded once the awaited jobs are done. Their
+// argument is 1 if other jobs may still be running.
+
+void nnx_busywait(nnx_dev_t *dev) {
+  NE16_BUSYWAIT(dev);
+  NNX_TRACE_EVENT(traceEventCompletion, 0);
 }
 
-void nnx_wait_empty() {
-  while(!nnx_empty()) NE16_BARRIER_NOSTATUS();
+void nnx_wait_empty(nnx_dev_t *dev) {
+  while(!nnx_empty(dev)) NE16_BARRIER_NOSTATUS(dev);
+  NNX_TRACE_EVENT(traceEventCompletion, 0);
 }
 
-void nnx_wait_not_full() {
-  while(nnx_full()) NE16_BARRIER_NOSTATUS();
+void nnx_wait_not_full(nnx_dev_t *dev) {
+  if (!nnx_full(dev))
+    return;
+  while(nnx_full(dev)) NE16_BARRIER_NOSTATUS(dev);
+  NNX_TRACE_EVENT(traceEventCompletion, 1);
 }
 
-void nnx_wait_on_id(const uint8_t id) {
-  while(nnx_job_id() <= id) {
-    eu_evt_maskWaitAndClr (1 << NE16_EVT0);
+void nnx_wait_on_id(nnx_dev_t *dev, const uint8_t id) {
+  while(nnx_job_id(dev) <= id) {
+    eu_evt_maskWaitAndClr (1 << dev->event);
   };
+  NNX_TRACE_EVENT(traceEventCompletion, 1);
 }
 
 void nnx_task_init(nnx_task_t *task) {
@@ -154,9 +220,17 @@ void nnx_mask_filter(nnx_cfg_t *cfg, const uint8_t top, const uint8_t right,
               ((uint32_t)bottom << 8) | ((uint32_t)left << 0);
 }
 
-nnx_error_code nnx_conv_1x1_update_dims(nnx_cfg_t *cfg,
+void nnx_streamin(nnx_cfg_t *cfg, const int enable) {
+  if (enable)
+    BIT_SET(cfg->conf0, NE16_FLAG_STREAMIN);
+  else
+    cfg->conf0 &= ~NE16_FLAG_STREAMIN;
+}
+
+nnx_error_code nnx_conv_1x1_update_dims(nnx_dev_t *dev, nnx_cfg_t *cfg,
     const int h_out, const int w_out, const int w_in, const int k_out, const int k_in,
-    const int w_in_stride, const int w_out_stride, const nnx_padding_t padding) {
+    const int w_in_stride, const int w_out_stride, const int k_in_stride, const int k_out_stride,
+    const nnx_padding_t padding) {
 
   const int num_Ko = DIVNCEIL(k_out, NE16_OUTPUT_CHANNEL_THROUGHPUT);
   const int num_Ki = DIVNCEIL(k_in, NE16_INPUT_CHANNEL_THROUGHPUT);
@@ -185,22 +259,22 @@ nnx_error_code nnx_conv_1x1_update_dims(nnx_cfg_t *cfg,
 
   // Strides
   const nnx_stride_t input_stride = {
-    .d0 = k_in,
-    .d1 = k_in * w_in_stride,
+    .d0 = k_in_stride,
+    .d1 = k_in_stride * w_in_stride,
     .d2 = k_in * NE16_FILTER_BUFFER_SIZE * NE16_FILTER_BUFFER_SIZE
   };
   cfg->input_stride = input_stride;
 
   const nnx_stride_t output_stride = {
     .d0 = 32,
-    .d1 = (k_out * outbytes) >> stride_shift,
-    .d2 = (k_out * outbytes * w_out) >> stride_shift
+    .d1 = (k_out_stride * dev->outbytes) >> dev->stride_shift,
+    .d2 = (k_out_stride * dev->outbytes * w_out_stride) >> dev->stride_shift
   };
   cfg->output_stride = output_stride;
 
   const nnx_stride_t weights_stride = {
-    .d0 = weight_d0_stride * qw,
-    .d1 = weight_d0_stride * qw * num_Ki,
+    .d0 = dev->weight_d0_stride * dev->qw,
+    .d1 = dev->weight_d0_stride * dev->qw * num_Ki,
     .d2 = 0 // Unused
   };
   cfg->weights_stride = weights_stride;
@@ -208,7 +282,7 @@ nnx_error_code nnx_conv_1x1_update_dims(nnx_cfg_t *cfg,
   return 0;
 }
 
-nnx_error_code nnx_conv_1x1(nnx_cfg_t *cfg,
+nnx_error_code nnx_conv_1x1(nnx_dev_t *dev, nnx_cfg_t *cfg,
                 const nnx_weights_t weights,
                 const nnx_feature_t input,
                 const nnx_feature_t output,
@@ -234,28 +308,35 @@ nnx_error_code nnx_conv_1x1(nnx_cfg_t *cfg,
     return unsupportedStride;
   }
 
+  if (!nnx_view_fits(&input) || !nnx_view_fits(&output)) {
+    return dimensionMismatch;
+  }
+
   const int mode16 =
     input.bitwidth == 16 ? NE16_FLAG_MODE16 : NE16_FLAG_MODE_BASIC;
 
   BIT_SET(cfg->conf0, weights.offset_mode | NE16_FLAG_MODE_1x1 | mode16 |
                  (weights.bitwidth - 1));
 
-  // Global static variables needed by update_dims
-  outbytes = output.bitwidth / 8;
-  weight_d0_stride =
+  // Device state needed by update_dims
+  dev->outbytes = output.bitwidth / 8;
+  dev->weight_d0_stride =
     mode16 ? NE16_WEIGHT_D0_STRIDE_MODE16 : NE16_WEIGHT_D0_STRIDE_MODE8;
-  qw = weights.bitwidth;
+  dev->qw = weights.bitwidth;
 
-  nnx_conv_1x1_update_dims(cfg, output.height, output.width, input.width, output.depth, input.depth, input.width, output.width, padding);
+  nnx_conv_1x1_update_dims(dev, cfg, output.height, output.width, input.width, output.depth, input.depth,
+                           nnx_row_stride(&input), nnx_row_stride(&output),
+                           nnx_channel_stride(&input), nnx_channel_stride(&output), padding);
 
   cfg->weight_offset_factor = weights.offset_factor;
 
   return 0;
 }
 
-nnx_error_code nnx_conv_3x3_update_dims(nnx_cfg_t *cfg,
+nnx_error_code nnx_conv_3x3_update_dims(nnx_dev_t *dev, nnx_cfg_t *cfg,
     const int h_out, const int w_out, const int w_in, const int k_out, const int k_in,
-    const int w_in_stride, const int w_out_stride, const nnx_padding_t padding) {
+    const int w_in_stride, const int w_out_stride, const int k_in_stride, const int k_out_stride,
+    const nnx_padding_t padding) {
 
   const int num_Ko = DIVNCEIL(k_out, NE16_OUTPUT_CHANNEL_THROUGHPUT);
   const int num_Ki = DIVNCEIL(k_in, NE16_INPUT_CHANNEL_THROUGHPUT);
@@ -284,22 +365,22 @@ nnx_error_code nnx_conv_3x3_update_dims(nnx_cfg_t *cfg,
 
   // Strides
   const nnx_stride_t input_stride = {
-    .d0 = k_in,
-    .d1 = k_in * w_in_stride,
+    .d0 = k_in_stride,
+    .d1 = k_in_stride * w_in_stride,
     .d2 = k_in * NE16_FILTER_BUFFER_SIZE * NE16_FILTER_BUFFER_SIZE
   };
   cfg->input_stride = input_stride;
 
   const nnx_stride_t output_stride = {
     .d0 = 32,
-    .d1 = (k_out * outbytes) >> stride_shift,
-    .d2 = (k_out * outbytes * w_out_stride) >> stride_shift
+    .d1 = (k_out_stride * dev->outbytes) >> dev->stride_shift,
+    .d2 = (k_out_stride * dev->outbytes * w_out_stride) >> dev->stride_shift
   };
   cfg->output_stride = output_stride;
 
   const nnx_stride_t weights_stride = {
-    .d0 = NE16_FILTER_SIZE * NE16_FILTER_SIZE * weight_d0_stride,
-    .d1 = NE16_FILTER_SIZE * NE16_FILTER_SIZE * weight_d0_stride * qw * num_Ki,
+    .d0 = NE16_FILTER_SIZE * NE16_FILTER_SIZE * dev->weight_d0_stride,
+    .d1 = NE16_FILTER_SIZE * NE16_FILTER_SIZE * dev->weight_d0_stride * dev->qw * num_Ki,
     .d2 = 0  // Unused
   };
   cfg->weights_stride = weights_stride;
@@ -307,7 +388,7 @@ nnx_error_code nnx_conv_3x3_update_dims(nnx_cfg_t *cfg,
   return 0;
 }
 
-nnx_error_code nnx_conv_3x3(nnx_cfg_t *cfg,
+nnx_error_code nnx_conv_3x3(nnx_dev_t *dev, nnx_cfg_t *cfg,
                 const nnx_weights_t weights,
                 const nnx_feature_t input,
                 const nnx_feature_t output,
@@ -333,6 +414,10 @@ nnx_error_code nnx_conv_3x3(nnx_cfg_t *cfg,
     return unsupportedStride;
   }
 
+  if (!nnx_view_fits(&input) || !nnx_view_fits(&output)) {
+    return dimensionMismatch;
+  }
+
   const int mode16 =
     input.bitwidth == 16 ? NE16_FLAG_MODE16 : NE16_FLAG_MODE_BASIC;
 
@@ -341,23 +426,26 @@ nnx_error_code nnx_conv_3x3(nnx_cfg_t *cfg,
   BIT_SET(cfg->conf0, weights.offset_mode | NE16_FLAG_MODE_3x3 | mode16 |
                  (weights.bitwidth - 1) | flag_stride2x2);
 
-  // Global static variables needed by update_dims
-  outbytes = output.bitwidth / 8;
-  weight_d0_stride =
+  // Device state needed by update_dims
+  dev->outbytes = output.bitwidth / 8;
+  dev->weight_d0_stride =
     mode16 ? NE16_WEIGHT_D0_STRIDE_MODE16 : NE16_WEIGHT_D0_STRIDE_MODE8;
-  qw = weights.bitwidth;
-  stride_shift = stride == 2 ? 1 : 0;
+  dev->qw = weights.bitwidth;
+  dev->stride_shift = stride == 2 ? 1 : 0;
 
-  nnx_conv_3x3_update_dims(cfg, output.height, output.width, input.width, output.depth, input.depth, input.width, output.width, padding);
+  nnx_conv_3x3_update_dims(dev, cfg, output.height, output.width, input.width, output.depth, input.depth,
+                           nnx_row_stride(&input), nnx_row_stride(&output),
+                           nnx_channel_stride(&input), nnx_channel_stride(&output), padding);
   
   cfg->weight_offset_factor = weights.offset_factor;
 
   return 0;
 }
 
-nnx_error_code nnx_conv_3x3_dw_update_dims(nnx_cfg_t *cfg,
+nnx_error_code nnx_conv_3x3_dw_update_dims(nnx_dev_t *dev, nnx_cfg_t *cfg,
     const int h_out, const int w_out, const int w_in, const int k_out, const int k_in,
-    const int w_in_stride, const int w_out_stride, const nnx_padding_t padding) {
+    const int w_in_stride, const int w_out_stride, const int k_in_stride, const int k_out_stride,
+    const nnx_padding_t padding) {
 
   const int num_Ko = DIVNCEIL(k_out, NE16_INPUT_CHANNEL_THROUGHPUT);
   const int num_Ki = num_Ko;
@@ -386,21 +474,21 @@ nnx_error_code nnx_conv_3x3_dw_update_dims(nnx_cfg_t *cfg,
 
   // Strides
   const nnx_stride_t input_stride = {
-    .d0 = k_out,
-    .d1 = k_out * w_in_stride,
+    .d0 = k_in_stride,
+    .d1 = k_in_stride * w_in_stride,
     .d2 = 0 // Unused
   };
   cfg->input_stride = input_stride;
 
   const nnx_stride_t output_stride = {
     .d0 = 32,
-    .d1 = (k_out * outbytes) >> stride_shift,
-    .d2 = (k_out * outbytes * w_out_stride) >> stride_shift
+    .d1 = (k_out_stride * dev->outbytes) >> dev->stride_shift,
+    .d2 = (k_out_stride * dev->outbytes * w_out_stride) >> dev->stride_shift
   };
   cfg->output_stride = output_stride;
 
   const nnx_stride_t weights_stride = {
-    .d0 = NE16_FILTER_SIZE * NE16_FILTER_SIZE * weight_d0_stride,
+    .d0 = NE16_FILTER_SIZE * NE16_FILTER_SIZE * dev->weight_d0_stride,
     .d1 = 0,
     .d2 = 0  // Unused
   };
@@ -409,7 +497,7 @@ nnx_error_code nnx_conv_3x3_dw_update_dims(nnx_cfg_t *cfg,
   return 0;
 }
 
-nnx_error_code nnx_conv_3x3_dw(nnx_cfg_t *cfg,
+nnx_error_code nnx_conv_3x3_dw(nnx_dev_t *dev, nnx_cfg_t *cfg,
                 const nnx_weights_t weights,
                 const nnx_feature_t input,
                 const nnx_feature_t output,
@@ -435,20 +523,26 @@ nnx_error_code nnx_conv_3x3_dw(nnx_cfg_t *cfg,
     return unsupportedStride;
   }
 
+  if (!nnx_view_fits(&input) || !nnx_view_fits(&output)) {
+    return dimensionMismatch;
+  }
+
   const int mode16 =
     input.bitwidth == 16 ? NE16_FLAG_MODE16 : NE16_FLAG_MODE_BASIC;
 
   BIT_SET(cfg->conf0, weights.offset_mode | NE16_FLAG_MODE_3x3_DW | mode16 |
                  (weights.bitwidth - 1));
 
-  // Global static variables needed by update_dims
-  outbytes = output.bitwidth / 8;
-  weight_d0_stride =
+  // Device state needed by update_dims
+  dev->outbytes = output.bitwidth / 8;
+  dev->weight_d0_stride =
     mode16 ? NE16_WEIGHT_D0_STRIDE_MODE16 : NE16_WEIGHT_D0_STRIDE_MODE8;
-  qw = weights.bitwidth;
-  stride_shift = stride == 2 ? 1 : 0;
+  dev->qw = weights.bitwidth;
+  dev->stride_shift = stride == 2 ? 1 : 0;
 
-  nnx_conv_3x3_dw_update_dims(cfg, output.height, output.width, input.width, output.depth, input.depth, input.width, output.width, padding);
+  nnx_conv_3x3_dw_update_dims(dev, cfg, output.height, output.width, input.width, output.depth, input.depth,
+                              nnx_row_stride(&input), nnx_row_stride(&output),
+                              nnx_channel_stride(&input), nnx_channel_stride(&output), padding);
   
   cfg->weight_offset_factor = weights.offset_factor;
 
@@ -0,0 +1,512 @@
+/*
+ * pulp_nnx_rt.c
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nnx_rt.h"
+#include "pulp_nnx_view.h"
+#include "pulp_nnx_trace.h"
+
+void nnx_run_batch(nnx_dev_t *dev, nnx_task_t *task,
+                   const uint32_t infeat_ptr, const uint32_t infeat_frame_size,
+                   const uint32_t outfeat_ptr, const uint32_t outfeat_frame_size,
+                   const int n_frames) {
+  for (int i = 0; i < n_frames; i++) {
+    task->infeat_ptr = infeat_ptr + i * infeat_frame_size;
+    task->outfeat_ptr = outfeat_ptr + i * outfeat_frame_size;
+
+    // Blocks until one of the contexts is free, so the next frame is queued
+    // while the previous one is still running.
+    nnx_acquire(dev);
+
+    // Every context keeps its register file between jobs. Once all of them
+    // have been programmed, it is enough to update the pointers.
+    if (i < NNX_CONTEXT_SIZE)
+      nnx_offload(dev, task);
+    else
+      nnx_offload_ptr(dev, task);
+
+    nnx_run_async(dev);
+  }
+
+  nnx_wait_empty(dev);
+}
+
+typedef struct {
+  int h0, w0, k0; // Output tile origin
+  int h, w, k;    // Output tile size
+  int spatial;    // Spatial tile index
+  int channel;    // Channel tile index
+} nnx_tile_pos_t;
+
+static inline int nnx_min(const int a, const int b) {
+  return a < b ? a : b;
+}
+
+static inline int nnx_is_depthwise(const nnx_tiled_layer_t *layer) {
+  return (layer->task->cfg.conf0 & NE16_MASK_FILTER_MODE) == NE16_FLAG_MODE_3x3_DW;
+}
+
+// Copies a (height x width x depth) tile between a dense L1 buffer and an HWC
+// tensor in L2 with the given row and pixel strides. All sizes are in bytes.
+static void nnx_dma_tile(uint8_t *ext, uint8_t *loc,
+                         const int height, const int width, const int depth,
+                         const int ext_row_stride, const int ext_pixel_stride,
+                         const pi_cl_dma_dir_e dir) {
+  pi_cl_dma_cmd_t cmd;
+
+  NNX_TRACE_EVENT(traceEventDmaStart, height * width * depth);
+
+  if (depth == ext_pixel_stride) {
+    pi_cl_dma_cmd_2d((uint32_t)ext, (uint32_t)loc, height * width * depth,
+                     ext_row_stride, width * depth, dir, &cmd);
+    pi_cl_dma_cmd_wait(&cmd);
+  } else {
+    for (int i = 0; i < height; i++) {
+      pi_cl_dma_cmd_2d((uint32_t)(ext + i * ext_row_stride), (uint32_t)(loc + i * width * depth),
+                       width * depth, ext_pixel_stride, depth, dir, &cmd);
+      pi_cl_dma_cmd_wait(&cmd);
+    }
+  }
+
+  NNX_TRACE_EVENT(traceEventDmaFinish, 0);
+}
+
+static void nnx_tile_pos(const nnx_tiled_layer_t *layer, const nnx_tile_plan_t plan,
+                         const int i, nnx_tile_pos_t *pos) {
+  const int n_w = DIVNCEIL(layer->output.width, plan.width);
+  const int n_k = DIVNCEIL(layer->output.depth, plan.depth);
+  const int n_spatial = DIVNCEIL(layer->output.height, plan.height) * n_w;
+
+  if (plan.order == tileOrderSpatialOuter) {
+    pos->spatial = i / n_k;
+    pos->channel = i % n_k;
+  } else {
+    pos->spatial = i % n_spatial;
+    pos->channel = i / n_spatial;
+  }
+
+  pos->h0 = (pos->spatial / n_w) * plan.height;
+  pos->w0 = (pos->spatial % n_w) * plan.width;
+  pos->k0 = pos->channel * plan.depth;
+  pos->h = nnx_min(plan.height, layer->output.height - pos->h0);
+  pos->w = nnx_min(plan.width, layer->output.width - pos->w0);
+  pos->k = nnx_min(plan.depth, layer->output.depth - pos->k0);
+}
+
+static void nnx_tile_load(nnx_tiled_layer_t *layer, const nnx_tile_pos_t *pos,
+                          const nnx_tile_buffer_t *buffer, nnx_tile_pos_t *loaded) {
+  const int ks = layer->weights.height;
+  const int is_dw = nnx_is_depthwise(layer);
+
+  // Depthwise input tiles are sliced along the channels too
+  if (loaded->spatial != pos->spatial || (is_dw && loaded->channel != pos->channel)) {
+    const int pixel_stride = nnx_channel_stride(&layer->input);
+    const int row_stride = nnx_row_stride(&layer->input) * pixel_stride;
+    const int k0 = is_dw ? pos->k0 : 0;
+    const int k = is_dw ? pos->k : layer->input.depth;
+    uint8_t *ext = (uint8_t *)layer->input.data + pos->h0 * row_stride + pos->w0 * pixel_stride + k0;
+    nnx_dma_tile(ext, buffer->input, pos->h + ks - 1, pos->w + ks - 1, k,
+                 row_stride, pixel_stride, PI_CL_DMA_DIR_EXT2LOC);
+  }
+
+  if (loaded->channel != pos->channel) {
+    // Weights of consecutive output channels are contiguous in the packed
+    // layout. Depthwise weights are packed in groups of 16 channels.
+    const int group = is_dw ? NE16_INPUT_CHANNEL_THROUGHPUT : 1;
+    const int ki_blocks = is_dw ? 1 : DIVNCEIL(layer->weights.depth, NE16_INPUT_CHANNEL_THROUGHPUT);
+    const int group_size = ki_blocks * layer->weights.bitwidth * layer->weights.height * layer->weights.width
+                           * NE16_INPUT_CHANNEL_THROUGHPUT / 8;
+    const int g0 = pos->k0 / group;
+    const int n_groups = DIVNCEIL(pos->k, group);
+    pi_cl_dma_cmd_t cmd;
+
+    if (layer->compressed != NULL) {
+      const nnx_compressed_weights_t *compressed = layer->compressed;
+      const uint32_t start = compressed->offsets[g0];
+      const uint32_t size = compressed->offsets[g0 + n_groups] - start;
+
+      if (size > 0) {
+        NNX_TRACE_EVENT(traceEventDmaStart, size);
+        pi_cl_dma_cmd((uint32_t)(compressed->literals + start), (uint32_t)buffer->compressed, size,
+                      PI_CL_DMA_DIR_EXT2LOC, &cmd);
+        pi_cl_dma_cmd_wait(&cmd);
+        NNX_TRACE_EVENT(traceEventDmaFinish, 0);
+      }
+
+      const uint32_t t0 = pi_perf_read(PI_PERF_CYCLES);
+      nnx_decompress_weights(compressed, buffer->compressed, buffer->weights, g0, n_groups);
+      layer->stats.decompress_cycles += pi_perf_read(PI_PERF_CYCLES) - t0;
+    } else {
+      NNX_TRACE_EVENT(traceEventDmaStart, n_groups * group_size);
+      pi_cl_dma_cmd((uint32_t)((uint8_t *)layer->weights.data + g0 * group_size),
+                    (uint32_t)buffer->weights, n_groups * group_size,
+                    PI_CL_DMA_DIR_EXT2LOC, &cmd);
+      pi_cl_dma_cmd_wait(&cmd);
+      NNX_TRACE_EVENT(traceEventDmaFinish, 0);
+    }
+
+    NNX_TRACE_EVENT(traceEventDmaStart, pos->k * layer->scale_bytes);
+    pi_cl_dma_cmd((uint32_t)((uint8_t *)layer->scale + pos->k0 * layer->scale_bytes),
+                  (uint32_t)buffer->scale, pos->k * layer->scale_bytes,
+                  PI_CL_DMA_DIR_EXT2LOC, &cmd);
+    pi_cl_dma_cmd_wait(&cmd);
+    NNX_TRACE_EVENT(traceEventDmaFinish, 0);
+  }
+
+  *loaded = *pos;
+}
+
+static void nnx_tile_store(const nnx_tiled_layer_t *layer, const nnx_tile_pos_t *pos,
+                           const nnx_tile_buffer_t *buffer) {
+  const int outbytes = layer->output.bitwidth / 8;
+  const int pixel_stride = nnx_channel_stride(&layer->output) * outbytes;
+  const int row_stride = nnx_row_stride(&layer->output) * pixel_stride;
+  uint8_t *ext = (uint8_t *)layer->output.data
+                 + pos->h0 * row_stride + pos->w0 * pixel_stride + pos->k0 * outbytes;
+  nnx_dma_tile(ext, buffer->output, pos->h, pos->w, pos->k * outbytes,
+               row_stride, pixel_stride, PI_CL_DMA_DIR_LOC2EXT);
+}
+
+// Runs the epilogue on a computed tile and stores it
+static void nnx_tile_finish(const nnx_tiled_layer_t *layer, const nnx_tile_pos_t *pos,
+                            const nnx_tile_buffer_t *buffer) {
+  if (layer->epilogue.fn != NULL) {
+    const nnx_tile_t tile = {
+      .data = buffer->output,
+      .h0 = pos->h0, .w0 = pos->w0, .k0 = pos->k0,
+      .height = pos->h, .width = pos->w, .depth = pos->k
+    };
+    nnx_run_epilogue(&layer->epilogue, &tile);
+  }
+
+  if (layer->output.data != NULL)
+    nnx_tile_store(layer, pos, buffer);
+}
+
+static void nnx_tile_run(nnx_tiled_layer_t *layer, const nnx_tile_pos_t *pos,
+                         const nnx_tile_buffer_t *buffer) {
+  nnx_dev_t *dev = layer->dev;
+  nnx_task_t *task = layer->task;
+  const int ks = layer->weights.height;
+  const int w_in = pos->w + ks - 1;
+  const int k_in = layer->input.depth;
+  const nnx_padding_t padding = { 0 };
+
+  // Tiles are dense in L1, whatever the strides of the tensors in L2
+  switch (task->cfg.conf0 & NE16_MASK_FILTER_MODE) {
+    case NE16_FLAG_MODE_1x1:
+      nnx_conv_1x1_update_dims(dev, &task->cfg, pos->h, pos->w, w_in, pos->k, k_in, w_in, pos->w, k_in, pos->k, padding);
+      break;
+    case NE16_FLAG_MODE_3x3:
+      nnx_conv_3x3_update_dims(dev, &task->cfg, pos->h, pos->w, w_in, pos->k, k_in, w_in, pos->w, k_in, pos->k, padding);
+      break;
+    case NE16_FLAG_MODE_3x3_DW:
+      nnx_conv_3x3_dw_update_dims(dev, &task->cfg, pos->h, pos->w, w_in, pos->k, pos->k, w_in, pos->w, pos->k, pos->k, padding);
+      break;
+  }
+
+  task->infeat_ptr = (uint32_t)buffer->input;
+  task->outfeat_ptr = (uint32_t)buffer->output;
+  task->weights_ptr = (uint32_t)buffer->weights;
+  task->scale_ptr = (uint32_t)buffer->scale;
+
+  // Tile dimensions may change between tiles so the whole task is offloaded
+  nnx_acquire(dev);
+  nnx_offload(dev, task);
+  nnx_run_async(dev);
+}
+
+// Runs tiles [first, last) of the layer
+static void nnx_run_tiles(nnx_tiled_layer_t *layer, const nnx_tile_plan_t plan,
+                          const int first, const int last) {
+  nnx_dev_t *dev = layer->dev;
+  const int n_tiles = last - first;
+
+  if (n_tiles <= 0)
+    return;
+
+  nnx_tile_pos_t pos[NNX_CONTEXT_SIZE];
+  nnx_tile_pos_t loaded[NNX_CONTEXT_SIZE] = {
+    { .spatial = -1, .channel = -1 },
+    { .spatial = -1, .channel = -1 }
+  };
+
+  nnx_tile_pos(layer, plan, first, &pos[0]);
+  nnx_tile_load(layer, &pos[0], &layer->buffer[0], &loaded[0]);
+
+  for (int i = 0; i < n_tiles; i++) {
+    const int cur = i % NNX_CONTEXT_SIZE;
+    const int other = !cur;
+
+    // Everything for tile i was prepared while tile i - 1 was running. If the
+    // NE16 is already idle, the cores were the bottleneck.
+    if (i > 0 && nnx_empty(dev))
+      layer->stats.ne16_idle++;
+
+    nnx_tile_run(layer, &pos[cur], &layer->buffer[cur]);
+
+    // Tile i - 1 used the other buffers, so it has to finish before they are
+    // reused. Tile i keeps the NE16 busy in the meantime.
+    nnx_wait_not_full(dev);
+
+    if (layer->arbitration != NULL)
+      nnx_set_arbitration(dev, layer->arbitration->concurrent);
+
+    // The other tile is finished before the next one is loaded, so the
+    // staging buffer of compressed weights may share memory with the output
+    // buffer of the same context (see arena.py).
+    if (i > 0)
+      nnx_tile_finish(layer, &pos[other], &layer->buffer[other]);
+
+    if (i + 1 < n_tiles) {
+      nnx_tile_pos(layer, plan, first + i + 1, &pos[other]);
+      nnx_tile_load(layer, &pos[other], &layer->buffer[other], &loaded[other]);
+    }
+
+    if (layer->arbitration != NULL)
+      nnx_set_arbitration(dev, layer->arbitration->exclusive);
+  }
+
+  nnx_wait_empty(dev);
+
+  const int final = (n_tiles - 1) % NNX_CONTEXT_SIZE;
+  nnx_tile_finish(layer, &pos[final], &layer->buffer[final]);
+}
+
+static int nnx_tile_count(const nnx_tiled_layer_t *layer, const nnx_tile_plan_t plan) {
+  return DIVNCEIL(layer->output.height, plan.height)
+         * DIVNCEIL(layer->output.width, plan.width)
+         * DIVNCEIL(layer->output.depth, plan.depth);
+}
+
+void nnx_run_tiled(nnx_tiled_layer_t *layer, const nnx_tile_plan_t plan) {
+  nnx_run_tiles(layer, plan, 0, nnx_tile_count(layer, plan));
+}
+
+void nnx_run_tiled_part(nnx_tiled_layer_t *layer, const nnx_tile_plan_t plan,
+                        const int part, const int n_parts) {
+  const int n_tiles = nnx_tile_count(layer, plan);
+  nnx_run_tiles(layer, plan, part * n_tiles / n_parts, (part + 1) * n_tiles / n_parts);
+}
+
+typedef struct {
+  nnx_tiled_layer_t *layers;
+  int n_devices;
+  nnx_tile_plan_t plan;
+} nnx_tiled_multi_fork_t;
+
+static void nnx_tiled_multi_entry(void *arg) {
+  nnx_tiled_multi_fork_t *fork = (nnx_tiled_multi_fork_t *)arg;
+  const int id = pi_core_id();
+  nnx_run_tiled_part(&fork->layers[id], fork->plan, id, fork->n_devices);
+}
+
+void nnx_run_tiled_multi(nnx_tiled_layer_t *layers, const int n_devices,
+                         const nnx_tile_plan_t plan) {
+  nnx_tiled_multi_fork_t fork = { .layers = layers, .n_devices = n_devices, .plan = plan };
+  pi_cl_team_fork(n_devices, nnx_tiled_multi_entry, &fork);
+}
+
+nnx_error_code nnx_run_grouped(nnx_grouped_conv_t *conv) {
+  nnx_dev_t *dev = conv->dev;
+  nnx_task_t *task = conv->task;
+
+  if (conv->n_jobs < 1 || conv->input.depth % conv->n_jobs != 0
+      || conv->output.depth % conv->n_jobs != 0) {
+    return dimensionMismatch;
+  }
+
+  const int k_in = conv->input.depth / conv->n_jobs;
+  const int k_out = conv->output.depth / conv->n_jobs;
+
+  for (int j = 0; j < conv->n_jobs; j++) {
+    const nnx_feature_t input = nnx_view_channels(&conv->input, j * k_in, k_in);
+    const nnx_feature_t output = nnx_view_channels(&conv->output, j * k_out, k_out);
+
+    task->infeat_ptr = (uint32_t)input.data;
+    task->outfeat_ptr = (uint32_t)output.data;
+    task->weights_ptr = (uint32_t)(conv->weights + j * conv->weights_job_size);
+    task->scale_ptr = (uint32_t)(conv->scale + j * k_out * conv->scale_bytes);
+
+    nnx_acquire(dev);
+
+    if (j < NNX_CONTEXT_SIZE)
+      nnx_offload(dev, task);
+    else
+      nnx_offload_ptr(dev, task);
+
+    nnx_run_async(dev);
+  }
+
+  nnx_wait_empty(dev);
+  return success;
+}
+
+nnx_error_code nnx_run_dilated(nnx_dilated_conv_t *conv) {
+  nnx_dev_t *dev = conv->dev;
+  nnx_task_t *task = conv->task;
+  const int d = conv->dilation;
+  const nnx_padding_t padding = { 0 };
+
+  if (d < 1 || conv->input.height < conv->output.height + 2 * d
+      || conv->input.width < conv->output.width + 2 * d) {
+    return dimensionMismatch;
+  }
+
+  // The update_dims functions trust the views, so every phase is checked
+  // before the first job is queued. Phases start at different pixels, which
+  // need not be word aligned even if the tensors are.
+  for (int ph = 0; ph < d && ph < conv->output.height; ph++) {
+    for (int pw = 0; pw < d && pw < conv->output.width; pw++) {
+      const int h = DIVNCEIL(conv->output.height - ph, d);
+      const int w = DIVNCEIL(conv->output.width - pw, d);
+      const nnx_feature_t input = nnx_view_dilated(&conv->input, ph, pw, d, h + 2, w + 2);
+      const nnx_feature_t output = nnx_view_dilated(&conv->output, ph, pw, d, h, w);
+
+      if (!nnx_view_fits(&input) || !nnx_view_fits(&output)) {
+        return dimensionMismatch;
+      }
+    }
+  }
+
+  for (int ph = 0; ph < d; ph++) {
+    for (int pw = 0; pw < d; pw++) {
+      // Outputs smaller than the dilation have empty phases
+      if (conv->output.height <= ph || conv->output.width <= pw)
+        continue;
+
+      const int h = DIVNCEIL(conv->output.height - ph, d);
+      const int w = DIVNCEIL(conv->output.width - pw, d);
+
+      const nnx_feature_t input = nnx_view_dilated(&conv->input, ph, pw, d, h + 2, w + 2);
+      const nnx_feature_t output = nnx_view_dilated(&conv->output, ph, pw, d, h, w);
+
+      if ((task->cfg.conf0 & NE16_MASK_FILTER_MODE) == NE16_FLAG_MODE_3x3_DW)
+        nnx_conv_3x3_dw_update_dims(dev, &task->cfg, h, w, w + 2, output.depth, input.depth,
+                                    nnx_row_stride(&input), nnx_row_stride(&output),
+                                    nnx_channel_stride(&input), nnx_channel_stride(&output), padding);
+      else
+        nnx_conv_3x3_update_dims(dev, &task->cfg, h, w, w + 2, output.depth, input.depth,
+                                 nnx_row_stride(&input), nnx_row_stride(&output),
+                                 nnx_channel_stride(&input), nnx_channel_stride(&output), padding);
+
+      task->infeat_ptr = (uint32_t)input.data;
+      task->outfeat_ptr = (uint32_t)output.data;
+
+      // Phases differ in size, so the whole task is offloaded
+      nnx_acquire(dev);
+      nnx_offload(dev, task);
+      nnx_run_async(dev);
+    }
+  }
+
+  nnx_wait_empty(dev);
+  return success;
+}
+
+static void nnx_residual_stage_entry(void *arg) {
+  const nnx_residual_conv_t *conv = (nnx_residual_conv_t *)arg;
+  const nnx_feature_t *skip = &conv->skip;
+  const nnx_feature_t *output = &conv->output;
+  const int32_t multiplier = conv->skip_rescale.multiplier;
+  const int shift = conv->skip_rescale.shift;
+  const int32_t round = shift > 0 ? 1 << (shift - 1) : 0;
+
+  const int chunk = DIVNCEIL(output->height, pi_cl_team_nb_cores());
+  const int start = pi_core_id() * chunk;
+  const int end = start + chunk < output->height ? start + chunk : output->height;
+
+  for (int h = start; h < end; h++) {
+    for (int w = 0; w < output->width; w++) {
+      const uint8_t *in = (uint8_t *)skip->data + (h * nnx_row_stride(skip) + w) * nnx_channel_stride(skip);
+      uint8_t *out = (uint8_t *)output->data + (h * nnx_row_stride(output) + w) * nnx_channel_stride(output);
+      for (int k = 0; k < output->depth; k++) {
+        const int32_t value = (in[k] * multiplier + round) >> shift;
+        out[k] = value < 0 ? 0 : value > 255 ? 255 : value;
+      }
+    }
+  }
+}
+
+void nnx_run_residual(nnx_residual_conv_t *conv) {
+  nnx_dev_t *dev = conv->dev;
+  nnx_task_t *task = conv->task;
+
+  const int in_place = conv->skip.data == conv->output.data
+                       && nnx_row_stride(&conv->skip) == nnx_row_stride(&conv->output)
+                       && nnx_channel_stride(&conv->skip) == nnx_channel_stride(&conv->output);
+  const int identity = conv->skip_rescale.multiplier == 1 && conv->skip_rescale.shift == 0;
+
+  if (!in_place || !identity) {
+    NNX_TRACE_EVENT(traceEventEpilogueStart, conv->output.height * conv->output.width * conv->output.depth);
+    pi_cl_team_fork(conv->n_cores, nnx_residual_stage_entry, conv);
+    NNX_TRACE_EVENT(traceEventEpilogueFinish, 0);
+  }
+
+  task->infeat_ptr = (uint32_t)conv->input.data;
+  task->outfeat_ptr = (uint32_t)conv->output.data;
+
+  nnx_acquire(dev);
+  nnx_offload(dev, task);
+  nnx_run(dev);
+}
+
+void nnx_run_fused_dw_pw(nnx_fused_block_t *block, const nnx_tile_plan_t plan) {
+  nnx_dev_t *dev = block->dev;
+  nnx_task_t *dw = block->dw_task;
+  nnx_task_t *pw = block->pw_task;
+  const int k_mid = block->input.depth;
+  const int k_out = block->output.depth;
+  const int outbytes = block->output.bitwidth / 8;
+  const int in_row_stride = nnx_row_stride(&block->input);
+  const int in_pixel_stride = nnx_channel_stride(&block->input);
+  const int out_row_stride = nnx_row_stride(&block->output);
+  const int out_pixel_stride = nnx_channel_stride(&block->output);
+  const nnx_padding_t padding = { 0 };
+
+  // Jobs are executed in order, so the pointwise job can be queued in the
+  // other context right away and the next depthwise job cannot overwrite the
+  // scratch buffer before the pointwise job has consumed it.
+  for (int h0 = 0; h0 < block->output.height; h0 += plan.height) {
+    for (int w0 = 0; w0 < block->output.width; w0 += plan.width) {
+      const int h = nnx_min(plan.height, block->output.height - h0);
+      const int w = nnx_min(plan.width, block->output.width - w0);
+
+      // Both jobs share the device state, so they must have the same
+      // bitwidths.
+      nnx_conv_3x3_dw_update_dims(dev, &dw->cfg, h, w, w + 2, k_mid, k_mid, in_row_stride, w, in_pixel_stride, k_mid, padding);
+      dw->infeat_ptr = (uint32_t)((uint8_t *)block->input.data + (h0 * in_row_stride + w0) * in_pixel_stride);
+      dw->outfeat_ptr = (uint32_t)block->scratch;
+
+      nnx_acquire(dev);
+      nnx_offload(dev, dw);
+      nnx_run_async(dev);
+
+      nnx_conv_1x1_update_dims(dev, &pw->cfg, h, w, w, k_out, k_mid, w, out_row_stride, k_mid, out_pixel_stride, padding);
+      pw->infeat_ptr = (uint32_t)block->scratch;
+      pw->outfeat_ptr = (uint32_t)((uint8_t *)block->output.data + (h0 * out_row_stride + w0) * out_pixel_stride * outbytes);
+
+      nnx_acquire(dev);
+      nnx_offload(dev, pw);
+      nnx_run_async(dev);
+    }
+  }
+
+  nnx_wait_empty(dev);
+}
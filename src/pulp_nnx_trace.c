@@ -0,0 +1,60 @@
+/*
+ * pulp_nnx_trace.c
+ * Luka Macan <luka.macan@fer.hr>
+ *
+ * Copyright (C) 2022 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nnx_trace.h"
+
+#if NNX_TRACE
+
+NNX_TRACE_MEMORY nnx_trace_ring_t nnx_trace_rings[NNX_TRACE_CORES];
+
+void nnx_trace_reset() {
+  for (int i = 0; i < NNX_TRACE_CORES; i++)
+    nnx_trace_rings[i].head = 0;
+
+  timer_reset(NNX_TRACE_TIMER);
+  timer_start(NNX_TRACE_TIMER);
+}
+
+void nnx_trace_dump() {
+  printf("NNX_TRACE_BEGIN %d %d\n", NNX_TRACE_CORES, NNX_TRACE_SIZE);
+
+  for (int core = 0; core < NNX_TRACE_CORES; core++) {
+    const nnx_trace_ring_t *ring = &nnx_trace_rings[core];
+    const uint32_t first = ring->head > NNX_TRACE_SIZE ? ring->head - NNX_TRACE_SIZE : 0;
+
+    // Number of overwritten events, so the decoder knows the trace is cut
+    printf("NNX_TRACE_CORE %d %u\n", core, first);
+
+    for (uint32_t i = first; i < ring->head; i++) {
+      const nnx_trace_entry_t *entry = &ring->entries[i & (NNX_TRACE_SIZE - 1)];
+      printf("NNX_TRACE_EVENT %d %u %d %d\n", core, entry->timestamp, entry->event, entry->arg);
+    }
+  }
+
+  printf("NNX_TRACE_END\n");
+}
+
+#else
+
+void nnx_trace_reset() {}
+
+void nnx_trace_dump() {}
+
+#endif  // NNX_TRACE
@@ -0,0 +1,184 @@
+# trace_decode.py
+# Luka Macan <luka.macan@fer.hr>
+#
+# Copyright (C) 2022 University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import sys
+import json
+import argparse
+
+# Must match nnx_trace_event_e in pulp_nnx_trace.h
+EVENTS = ['acquire', 'offload', 'trigger', 'completion', 'dma_start', 'dma_finish',
+          'epilogue_start', 'epilogue_finish', 'decompress_start', 'decompress_finish']
+
+# Phases delimited by a pair of events recorded by the same core
+PAIRED_PHASES = {
+    'dma': ('dma_start', 'dma_finish'),
+    'epilogue': ('epilogue_start', 'epilogue_finish'),
+    'decompress': ('decompress_start', 'decompress_finish'),
+    'setup': ('acquire', 'trigger')
+}
+
+
+def parse(lines):
+    """ Events of the last dump in the log, per core, as (timestamp, event, arg)
+
+    All cores read the 32-bit cluster timer. Timestamps are kept monotonic by
+    adding a timer period whenever it wraps around.
+    """
+    cores, lost = {}, {}
+    for line in lines:
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == 'NNX_TRACE_BEGIN':
+            cores, lost = {}, {}
+        elif fields[0] == 'NNX_TRACE_CORE':
+            core, n_lost = int(fields[1]), int(fields[2])
+            cores[core] = []
+            lost[core] = n_lost
+        elif fields[0] == 'NNX_TRACE_EVENT':
+            core, timestamp, event, arg = (int(f) for f in fields[1:5])
+            cores[core].append((timestamp, EVENTS[event], arg))
+
+    for core, events in cores.items():
+        offset, last = 0, 0
+        monotonic = []
+        for timestamp, event, arg in events:
+            if timestamp + offset < last:
+                offset += 1 << 32
+            last = timestamp + offset
+            monotonic.append((last, event, arg))
+        cores[core] = monotonic
+
+    return {core: events for core, events in cores.items() if events}, lost
+
+
+def phases(events):
+    """ Intervals (name, start, end) of one core's events
+
+    Jobs run from their trigger to the completion event that covers them.
+    Since the core only notices completions when it waits, job intervals are
+    an upper bound of the NE16 latency.
+    """
+    intervals = []
+    open_phases = {}
+    triggers = []
+    for timestamp, event, arg in events:
+        for name, (start, end) in PAIRED_PHASES.items():
+            if event == start:
+                open_phases[name] = timestamp
+            elif event == end and name in open_phases:
+                intervals.append((name, open_phases.pop(name), timestamp))
+
+        if event == 'trigger':
+            triggers.append(timestamp)
+        elif event == 'completion' and triggers:
+            # Only the oldest job is known to be done if others may be running
+            done = triggers[:1] if arg else triggers
+            for start in done:
+                intervals.append(('job', start, timestamp))
+            triggers = triggers[len(done):]
+
+    return intervals
+
+
+def histogram(durations, n_bins=8, width=40):
+    lines = []
+    low, high = min(durations), max(durations)
+    n_bins = min(n_bins, high - low + 1)
+    step = max(1, -(-(high - low + 1) // n_bins))
+    counts = [0] * n_bins
+    for d in durations:
+        counts[min((d - low) // step, n_bins - 1)] += 1
+    for i, count in enumerate(counts):
+        bar = '#' * (count * width // max(counts))
+        lines.append(f'  [{low + i * step:>8}, {low + (i + 1) * step:>8}) {count:>6} {bar}')
+    return lines
+
+
+def report(cores, lost, file=sys.stdout):
+    for core, n_lost in sorted(lost.items()):
+        if n_lost:
+            print(f'Core {core}: the {n_lost} oldest events were overwritten', file=file)
+
+    by_phase = {}
+    for events in cores.values():
+        for name, start, end in phases(events):
+            by_phase.setdefault(name, []).append(end - start)
+
+    for name, durations in sorted(by_phase.items()):
+        durations = sorted(durations)
+        print(f'{name}: {len(durations)} intervals, total {sum(durations)} cycles, '
+              f'min/median/max {durations[0]}/{durations[len(durations) // 2]}/{durations[-1]} cycles', file=file)
+        for line in histogram(durations):
+            print(line, file=file)
+
+
+def timeline(cores, file=sys.stdout):
+    start = min(events[0][0] for events in cores.values())
+    merged = sorted((timestamp, core, event, arg) for core, events in cores.items() for timestamp, event, arg in events)
+    for timestamp, core, event, arg in merged:
+        print(f'{timestamp - start:>10} core {core} {event:<18} {arg}', file=file)
+
+
+def chrome_trace(cores, freq):
+    """ Timeline in the Chrome trace event format, viewable in Perfetto
+
+    The format takes microseconds, so the cycles are divided by the cluster
+    frequency in MHz.
+    """
+    trace = []
+    for core, events in cores.items():
+        for name, start, end in phases(events):
+            # Jobs run on the NE16, so they get their own row next to the core
+            tid = f'ne16 (core {core})' if name == 'job' else f'core {core}'
+            trace.append({'name': name, 'ph': 'X', 'pid': 0, 'tid': tid, 'ts': start / freq, 'dur': (end - start) / freq,
+                          'args': {'cycles': end - start}})
+        for timestamp, event, arg in events:
+            trace.append({'name': event, 'ph': 'i', 's': 't', 'pid': 0, 'tid': f'core {core}',
+                          'ts': timestamp / freq, 'args': {'arg': arg, 'cycle': timestamp}})
+    return {'traceEvents': trace, 'displayTimeUnit': 'ns'}
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Decodes the event trace printed by nnx_trace_dump().')
+    parser.add_argument('log', nargs='?', type=argparse.FileType('r'), default=sys.stdin,
+                        help='Output of the run containing the dump. Default: stdin')
+    parser.add_argument('--timeline', action='store_true',
+                        help='Print every event in time order.')
+    parser.add_argument('--chrome', dest='chrome', default=None,
+                        help='Write the timeline in the Chrome trace event format to this file.')
+    parser.add_argument('--freq', type=float, default=None,
+                        help='Cluster frequency in MHz, converts the cycles of the --chrome timeline to microseconds.')
+    args = parser.parse_args()
+
+    if args.chrome is not None and args.freq is None:
+        parser.error('--chrome needs the cluster frequency given with --freq')
+
+    cores, lost = parse(args.log)
+
+    if not cores:
+        sys.exit('No trace found, was the application built with TRACE=1?')
+
+    if args.timeline:
+        timeline(cores)
+        print()
+
+    report(cores, lost)
+
+    if args.chrome is not None:
+        with open(args.chrome, 'w') as file:
+            json.dump(chrome_trace(cores, args.freq), file)
+        print(f'Timeline written to {args.chrome}')